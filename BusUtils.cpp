@@ -0,0 +1,83 @@
+/**
+ * @file BusUtils.cpp
+ * @brief Implementation file for the shared I2C bus manager.
+ * This file provides the definitions (logic) for the functions 
+ * declared in BusUtils.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h> /* millis() */
+#include <Wire.h>
+#include "Global.h"
+#include "BusUtils.h"
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief The pending reservation (time of the planned high priority transaction).
+ */
+PRIVATE bool BU_Reserved = false;
+PRIVATE unsigned long BU_ReservedTime = 0;
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Switches the I2C bus to I2C_CLOCK (call after the devices are initialized).
+ * The device drivers call Wire.begin() in their begin(), so the clock 
+ * is set after them.
+ */
+void Init_Bus() {
+  Wire.setClock(I2C_CLOCK);
+  BU_Reserved = false;
+}
+
+/**
+ * @brief Reserves the bus for a high priority transaction planned at the given time.
+ * The earliest of several reservations is kept.
+ * @param time The planned transaction time stamp (millis()).
+ */
+void ReserveBus(unsigned long time) {
+  if (!BU_Reserved || ((long)(time - BU_ReservedTime) < 0)) {
+    BU_ReservedTime = time;
+  }
+  BU_Reserved = true;
+}
+
+/**
+ * @brief Releases the reservation (the reserved transaction was done or cancelled).
+ */
+void ReleaseBus() {
+  BU_Reserved = false;
+}
+
+/**
+ * @brief Checks if a low priority transfer can start now.
+ * @return bool False from I2C_GUARD_TIME before the reserved time until ReleaseBus().
+ */
+bool IsBusFree() {
+  return IsBusFreeFor(0);
+}
+
+/**
+ * @brief Checks if a blocking operation of the given duration can start now 
+ * without delaying the reserved transaction.
+ * An overdue reservation keeps the bus blocked until the owner releases it.
+ * @param duration The max. duration of the operation [ms].
+ * @return bool False from duration + I2C_GUARD_TIME before the reserved time until ReleaseBus().
+ */
+bool IsBusFreeFor(unsigned long duration) {
+  if (!BU_Reserved) {
+    return true;
+  }
+  return (long)(BU_ReservedTime - millis()) > (long)(duration + I2C_GUARD_TIME);
+}
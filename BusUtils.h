@@ -0,0 +1,64 @@
+/**
+ * @file BusUtils.h
+ * @brief Header file for the shared I2C bus manager.
+ * The sensor and the display share one I2C bus. The bus runs in the 
+ * fast-mode (400 kHz). The sensor announces its next transaction with 
+ * ReserveBus(), the low priority transfers (display refresh) are sent 
+ * in small chunks and only while IsBusFree() allows it, so a sample 
+ * is never delayed by more than one chunk.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef BUS_UTILS_H
+#define BUS_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+#define I2C_CLOCK 400000UL /* I2C bus clock, fast-mode [Hz] */
+#define I2C_GUARD_TIME 2 /* No low priority transfer starts this close before a reserved transaction [ms] */
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Switches the I2C bus to I2C_CLOCK (call after the devices are initialized).
+ */
+void Init_Bus(void);
+
+/**
+ * @brief Reserves the bus for a high priority transaction planned at the given time.
+ * The earliest of several reservations is kept.
+ * @param time The planned transaction time stamp (millis()).
+ */
+void ReserveBus(unsigned long time);
+
+/**
+ * @brief Releases the reservation (the reserved transaction was done or cancelled).
+ */
+void ReleaseBus(void);
+
+/**
+ * @brief Checks if a low priority transfer can start now.
+ * @return bool False from I2C_GUARD_TIME before the reserved time until ReleaseBus().
+ */
+bool IsBusFree(void);
+
+/**
+ * @brief Checks if a blocking operation of the given duration can start now (e.g. a TCP connect).
+ * @param duration The max. duration of the operation [ms].
+ * @return bool False from duration + I2C_GUARD_TIME before the reserved time until ReleaseBus().
+ */
+bool IsBusFreeFor(unsigned long duration);
+
+#endif // BUS_UTILS_H
@@ -0,0 +1,203 @@
+/**
+ * @file ConfigUtils.cpp
+ * @brief Implementation file for the runtime configuration stored in LittleFS.
+ * This file provides the definitions (logic) for the functions
+ * declared in ConfigUtils.h.
+ * The file CONFIG_PATH holds one record: header (magic, version, length),
+ * the Config struct and a CRC32 over both. A missing, corrupted or older
+ * record is replaced by the defaults (the file is rewritten on the next
+ * change only).
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h>
+#include <LittleFS.h> /* Flash file system */
+#include <stddef.h>
+#include <string.h>
+#include "Global.h"
+#include "ConfigUtils.h"
+#include "DataUtils.h" /* Trend window limits */
+#include "RtcUtils.h" /* CalcCrc32() */
+#include "ConsoleUtils.h" /* Buffered serial log */
+
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+#define CF_DEADBAND_MAX 10000UL /* Max. deadband [0.01 C / 0.01 %] */
+
+// --------------------------------------------------------------------------
+// PRIVATE TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Config record in flash.
+ */
+typedef struct {
+  uint32_t magic;   /* CONFIG_MAGIC */
+  uint16_t version; /* CONFIG_VERSION */
+  uint16_t len;     /* sizeof(Config) */
+  Config config;
+  uint32_t crc;     /* CRC32 over the fields above */
+} CF_Record;
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Active configuration.
+ */
+PRIVATE Config CF_Config;
+
+/**
+ * @brief The active configuration was changed and not yet applied.
+ */
+PRIVATE bool CF_Changed = false;
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Checks if a period is in the CONFIG_PERIOD_MIN..CONFIG_PERIOD_MAX range.
+ */
+PRIVATE bool CF_IsPeriodValid(uint32_t period) {
+  return (period >= CONFIG_PERIOD_MIN) && (period <= CONFIG_PERIOD_MAX);
+}
+
+/**
+ * @brief Checks all fields of a configuration.
+ * @param config The checked configuration.
+ * @return bool True if all the values are in range.
+ */
+PRIVATE bool CF_IsValid(const Config* config) {
+  return (config->alphaNum > 0) && (config->alphaNum <= config->alphaDen) && (config->alphaDen <= 0xFFFF) &&
+         CF_IsPeriodValid(config->samplePeriod) &&
+         CF_IsPeriodValid(config->displayPeriod) &&
+         CF_IsPeriodValid(config->publishPeriod) &&
+         CF_IsPeriodValid(config->heartbeat) &&
+         (config->trendWindow >= TREND_MIN_COUNT) && (config->trendWindow <= TREND_COUNT) &&
+         (config->deadbandTmpr <= CF_DEADBAND_MAX) && (config->deadbandHum <= CF_DEADBAND_MAX);
+}
+
+/**
+ * @brief Reads the config record from flash.
+ * @param config Output configuration (not changed on failure).
+ * @return bool True if a valid record was read.
+ */
+PRIVATE bool CF_Load(Config* config) {
+  CF_Record record;
+
+  File f = LittleFS.open(CONFIG_PATH, "r");
+  if (!f) {
+    return false;
+  }
+  bool ok = (sizeof(record) == f.read((uint8_t*)&record, sizeof(record)));
+  f.close();
+
+  if (!ok || (CONFIG_MAGIC != record.magic) || (CONFIG_VERSION != record.version) ||
+      (sizeof(Config) != record.len) ||
+      (record.crc != CalcCrc32(&record, offsetof(CF_Record, crc))) ||
+      !CF_IsValid(&record.config)) {
+    return false;
+  }
+  *config = record.config;
+  return true;
+}
+
+/**
+ * @brief Writes the config record to flash.
+ * @param config The stored configuration.
+ * @return bool True on success.
+ */
+PRIVATE bool CF_Save(const Config* config) {
+  CF_Record record;
+
+  memset(&record, 0, sizeof(record)); /* Defined padding bytes for the CRC */
+  record.magic = CONFIG_MAGIC;
+  record.version = CONFIG_VERSION;
+  record.len = sizeof(Config);
+  record.config = *config;
+  record.crc = CalcCrc32(&record, offsetof(CF_Record, crc));
+
+  File f = LittleFS.open(CONFIG_PATH, "w");
+  if (!f) {
+    return false;
+  }
+  bool ok = (sizeof(record) == f.write((const uint8_t*)&record, sizeof(record)));
+  f.close();
+  return ok;
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Loads the stored configuration (the file system is mounted by the caller).
+ * Called once at boot, the values are applied by the caller (GetConfig()).
+ * @param defaults The compile-time values, used when no valid record is stored.
+ * @param fsMounted Result of the LittleFS mount (false = defaults used).
+ * @return bool True if a stored record was loaded (false = defaults).
+ */
+bool Init_Config(const Config* defaults, bool fsMounted) {
+  CF_Config = *defaults;
+  CF_Changed = false;
+
+  if (!fsMounted) {
+    return false; /* Reported by the caller */
+  }
+  if (!CF_Load(&CF_Config)) {
+    CONSOLE_INFO("No stored config, defaults used.");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Gets the active configuration.
+ * @return const Config* The active configuration (valid after Init_Config()).
+ */
+const Config* GetConfig() {
+  return &CF_Config;
+}
+
+/**
+ * @brief Checks a configuration and makes it the active one.
+ * The record is written only if a value changed, so a retained config
+ * message received on every reconnect does not wear the flash.
+ * @param config The new configuration.
+ * @return bool True if the configuration was valid (false = the active one is kept).
+ */
+bool SetConfig(const Config* config) {
+  if (!CF_IsValid(config)) {
+    CONSOLE_WARN("Config rejected: value out of range");
+    return false;
+  }
+  if (0 == memcmp(config, &CF_Config, sizeof(Config))) {
+    return true;
+  }
+  CF_Config = *config;
+  CF_Changed = true;
+  if (!CF_Save(&CF_Config)) {
+    CONSOLE_WARN("Config not stored (flash write failed)");
+  }
+  return true;
+}
+
+/**
+ * @brief Checks if the active configuration changed since the last call (flag is cleared).
+ * @return bool True if the configuration has to be applied.
+ */
+bool IsConfigChanged() {
+  bool changed = CF_Changed;
+  CF_Changed = false;
+  return changed;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file ConfigUtils.h
+ * @brief Header file for the runtime configuration stored in LittleFS.
+ * The tunable parameters (smoothing factor, task periods, trend window,
+ * deadband) are kept in one flat, versioned, CRC protected record in the
+ * flash file system. The record is loaded once at boot, a new one comes
+ * from the retained MQTT config topic, so no reflashing is needed.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef CONFIG_UTILS_H
+#define CONFIG_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <stdint.h>
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+#define CONFIG_PATH "/config.bin" /* Config record file */
+#define CONFIG_MAGIC 0x4746434CUL /* "LCFG" */
+#define CONFIG_VERSION 1 /* Layout of the Config struct, other versions are not loaded */
+
+/* Limits of the periods [ms] */
+#define CONFIG_PERIOD_MIN 1000UL
+#define CONFIG_PERIOD_MAX 3600000UL
+
+// --------------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Runtime configuration (stored in flash as is, fixed width fields).
+ */
+typedef struct {
+  uint32_t alphaNum;      /* Smoothing factor numerator (defined for ALPHA_SAMPLE_TIME) */
+  uint32_t alphaDen;      /* Smoothing factor denominator */
+  uint32_t samplePeriod;  /* Sensor sampling period [ms] (start value with the adaptive sampling) */
+  uint32_t displayPeriod; /* OLED display refresh period [ms] */
+  uint32_t publishPeriod; /* MQTT publish period [ms] */
+  uint32_t trendWindow;   /* Regression window [samples] (TREND_MIN_COUNT..TREND_COUNT) */
+  uint32_t deadbandTmpr;  /* Publish deadband of the temperature [0.01 C] */
+  uint32_t deadbandHum;   /* Publish deadband of the humidity [0.01 %] */
+  uint32_t heartbeat;     /* Max. time between two messages [ms] */
+} Config;
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Loads the stored configuration (the file system is mounted by the caller).
+ * @param defaults The compile-time values, used when no valid record is stored.
+ * @param fsMounted Result of the LittleFS mount (false = defaults used).
+ * @return bool True if a stored record was loaded (false = defaults).
+ */
+bool Init_Config(const Config* defaults, bool fsMounted);
+
+/**
+ * @brief Gets the active configuration.
+ * @return const Config* The active configuration (valid after Init_Config()).
+ */
+const Config* GetConfig(void);
+
+/**
+ * @brief Checks a configuration and makes it the active one (stored only when changed).
+ * @param config The new configuration.
+ * @return bool True if the configuration was valid (false = the active one is kept).
+ */
+bool SetConfig(const Config* config);
+
+/**
+ * @brief Checks if the active configuration changed since the last call (flag is cleared).
+ * @return bool True if the configuration has to be applied.
+ */
+bool IsConfigChanged(void);
+
+#endif // CONFIG_UTILS_H
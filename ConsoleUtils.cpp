@@ -0,0 +1,151 @@
+/**
+ * @file ConsoleUtils.cpp
+ * @brief Implementation file for the buffered serial console (log messages).
+ * This file provides the definitions (logic) for the functions 
+ * declared in ConsoleUtils.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h> /* Serial */
+#include <stdarg.h>
+#include <stdio.h>
+#include "Global.h"
+#include "ConsoleUtils.h"
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Ring buffer of the formatted output (oldest byte at CU_Tail).
+ */
+PRIVATE char CU_Buffer[CONSOLE_BUFFER_SIZE];
+PRIVATE UW CU_Tail = 0;
+PRIVATE UW CU_Count = 0;
+
+/**
+ * @brief Dropped messages: total and not yet reported in the output.
+ */
+PRIVATE unsigned long CU_Dropped = 0;
+PRIVATE unsigned long CU_DroppedUnreported = 0;
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Copies a message into the ring buffer (caller checked the free space).
+ */
+PRIVATE void CU_Put(const char* text, UW len) {
+  UW head = (CU_Tail + CU_Count) % CONSOLE_BUFFER_SIZE;
+
+  for (UW i = 0; i < len; i++) {
+    CU_Buffer[head] = text[i];
+    head = (head + 1) % CONSOLE_BUFFER_SIZE;
+  }
+  CU_Count += len;
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Initializes the serial port and the ring buffer.
+ * @param baudRate The serial speed [bits/sec].
+ */
+void Init_Console(unsigned long baudRate) {
+  Serial.begin(baudRate);
+  CU_Tail = 0;
+  CU_Count = 0;
+}
+
+/**
+ * @brief Formats one message into the ring buffer (use the CONSOLE_x macros).
+ * A message which does not fit is dropped as a whole and counted, the 
+ * number of the dropped messages is reported before the next stored one.
+ * Longer messages are cut at CONSOLE_LINE_LEN.
+ * @param format The printf format string (without the line end).
+ */
+void ConsolePrintf(const char* format, ...) {
+  char line[CONSOLE_LINE_LEN];
+  va_list args;
+
+  va_start(args, format);
+  int len = vsnprintf(line, sizeof(line) - 2, format, args); /* Room for "\r\n" */
+  va_end(args);
+
+  if (len < 0) {
+    return;
+  }
+  if (len > (int)(sizeof(line) - 3)) {
+    len = (int)(sizeof(line) - 3);
+  }
+  line[len++] = '\r';
+  line[len++] = '\n';
+
+  if (CU_DroppedUnreported > 0) {
+    char note[40];
+    int noteLen = snprintf(note, sizeof(note), "... %lu lines dropped\r\n", CU_DroppedUnreported);
+    if ((noteLen > 0) && ((CU_Count + noteLen) <= CONSOLE_BUFFER_SIZE)) {
+      CU_Put(note, (UW)noteLen);
+      CU_DroppedUnreported = 0;
+    }
+  }
+
+  if ((CU_Count + len) > CONSOLE_BUFFER_SIZE) {
+    CU_Dropped++;
+    CU_DroppedUnreported++;
+    return;
+  }
+  CU_Put(line, (UW)len);
+}
+
+/**
+ * @brief Moves the buffered output to the UART as far as the TX FIFO has room (never waits).
+ */
+void Run_Console() {
+  while (CU_Count > 0) {
+    int room = Serial.availableForWrite();
+    if (room <= 0) {
+      return; /* FIFO full, continue on the next pass */
+    }
+
+    UW chunk = CONSOLE_BUFFER_SIZE - CU_Tail; /* Contiguous part up to the buffer end */
+    if (chunk > CU_Count) {
+      chunk = CU_Count;
+    }
+    if (chunk > (UW)room) {
+      chunk = (UW)room;
+    }
+
+    Serial.write((const uint8_t*)&CU_Buffer[CU_Tail], chunk);
+    CU_Tail = (CU_Tail + chunk) % CONSOLE_BUFFER_SIZE;
+    CU_Count -= chunk;
+  }
+}
+
+/**
+ * @brief Sends all buffered output, waits for the UART (before a halt or deep sleep only).
+ */
+void FlushConsole() {
+  while (CU_Count > 0) {
+    Run_Console();
+    yield();
+  }
+  Serial.flush();
+}
+
+/**
+ * @brief Gets the number of the dropped messages (buffer full).
+ * @return unsigned long The drop counter.
+ */
+unsigned long GetConsoleDropCount() {
+  return CU_Dropped;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file ConsoleUtils.h
+ * @brief Header file for the buffered serial console (log messages).
+ * A message is formatted once (printf style) into a RAM ring buffer and 
+ * sent by Run_Console() only as far as the UART TX FIFO has room, so the 
+ * loop never waits for the serial line. The levels above CONSOLE_LEVEL 
+ * are removed by the preprocessor (no code, no format strings).
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef CONSOLE_UTILS_H
+#define CONSOLE_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Log levels.
+ */
+#define CONSOLE_LEVEL_NONE 0  /* No output */
+#define CONSOLE_LEVEL_ERROR 1 /* Failures */
+#define CONSOLE_LEVEL_WARN 2  /* Recoverable problems (connection lost, retry) */
+#define CONSOLE_LEVEL_INFO 3  /* State changes and the measured values */
+#define CONSOLE_LEVEL_DEBUG 4 /* Internal data (trend buffer) */
+
+#define CONSOLE_LEVEL CONSOLE_LEVEL_INFO /* Highest compiled level */
+
+#define CONSOLE_LINE_LEN 160 /* Maximal length of one formatted message */
+#if (CONSOLE_LEVEL >= CONSOLE_LEVEL_DEBUG)
+#define CONSOLE_BUFFER_SIZE 4096 /* Ring buffer [B], the debug dumps need more room */
+#else
+#define CONSOLE_BUFFER_SIZE 512 /* Ring buffer [B] (~45 ms of output at 115200 Bd) */
+#endif /* CONSOLE_LEVEL */
+
+/**
+ * @brief Log macros (printf format, the line end is added).
+ * A disabled level is dead code (removed by the compiler), its arguments 
+ * are still type-checked and count as used.
+ */
+#if (CONSOLE_LEVEL >= CONSOLE_LEVEL_ERROR)
+#define CONSOLE_ERROR(...) ConsolePrintf("ERROR: " __VA_ARGS__)
+#else
+#define CONSOLE_ERROR(...) do { if (0) { ConsolePrintf(__VA_ARGS__); } } while (0)
+#endif
+
+#if (CONSOLE_LEVEL >= CONSOLE_LEVEL_WARN)
+#define CONSOLE_WARN(...) ConsolePrintf("WARN: " __VA_ARGS__)
+#else
+#define CONSOLE_WARN(...) do { if (0) { ConsolePrintf(__VA_ARGS__); } } while (0)
+#endif
+
+#if (CONSOLE_LEVEL >= CONSOLE_LEVEL_INFO)
+#define CONSOLE_INFO(...) ConsolePrintf(__VA_ARGS__)
+#else
+#define CONSOLE_INFO(...) do { if (0) { ConsolePrintf(__VA_ARGS__); } } while (0)
+#endif
+
+#if (CONSOLE_LEVEL >= CONSOLE_LEVEL_DEBUG)
+#define CONSOLE_DEBUG(...) ConsolePrintf("DEBUG: " __VA_ARGS__)
+#else
+#define CONSOLE_DEBUG(...) do { if (0) { ConsolePrintf(__VA_ARGS__); } } while (0)
+#endif
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Initializes the serial port and the ring buffer.
+ * @param baudRate The serial speed [bits/sec].
+ */
+void Init_Console(unsigned long baudRate);
+
+/**
+ * @brief Formats one message into the ring buffer (use the CONSOLE_x macros).
+ * A message which does not fit is dropped as a whole and counted.
+ * @param format The printf format string (without the line end).
+ */
+void ConsolePrintf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Moves the buffered output to the UART as far as the TX FIFO has room (never waits).
+ */
+void Run_Console(void);
+
+/**
+ * @brief Sends all buffered output, waits for the UART (before a halt or deep sleep only).
+ */
+void FlushConsole(void);
+
+/**
+ * @brief Gets the number of the dropped messages (buffer full).
+ * @return unsigned long The drop counter.
+ */
+unsigned long GetConsoleDropCount(void);
+
+#endif // CONSOLE_UTILS_H
@@ -15,32 +15,315 @@
 #include "Global.h"
 #include "DataUtils.h"
 #include <cmath>
+#include <math.h> /* roundf(), powf(), fabsf() */
+#include <stdlib.h> /* labs() */
+
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+/* Compile-time initial filter state of one channel (double math, constants only) */
+#if (DU_FIXED_POINT == 1)
+#define DU_STATE_FROM_VALUE(v) ((SL)(((v) * DU_POW10[DU_DECIMALS] * FILTER_FX_ONE) + 0.5)) /* Q16.16 hundredths */
+#else
+#define DU_STATE_FROM_VALUE(v) ((float)((v) * DU_POW10[DU_DECIMALS])) /* Hundredths */
+#endif
 
 // --------------------------------------------------------------------------
 // PRIVATE DATA (Static Variables)
 // --------------------------------------------------------------------------
 
 /**
- * @brief Internal state variable for the Exponential Smoothing filter.
- * * This variable is maintained between calls to Run_ExponentialSmooth().
+ * @brief Trend engine of one sensor: circular buffer and the regression sums.
+ * The running sums of the linear regression use x = 0 for the oldest sample; 
+ * integer sums are exact, so they do not drift over the runtime.
+ */
+typedef struct {
+  SW buffer[TREND_COUNT]; /* Temperature history [0.01 C] */
+  UW idx;                 /* Write index (points to the oldest value when full) */
+  UW count;               /* Number of valid samples (0..DU_TrendWindow) */
+  SL sumY;                /* Sum of y [0.01 C] */
+  long long sumXY;        /* Sum of x * y */
+} DU_Trend;
+static_assert(TREND_SNAPSHOT_COUNT <= TREND_COUNT, "TREND_SNAPSHOT_COUNT exceeds the trend buffer");
+
+/**
+ * @brief Exponential Smoothing filter (temperature, humidity) of each sensor.
+ * The state is maintained between calls to Run_TmprSmooth() / Run_HumiSmooth().
+ * Only the primary sensor has a compile-time default, the others are set 
+ * by Init_SensorSmooth().
+ */
+PRIVATE DU_Filter DU_Smooth[SENSOR_COUNT] = {{{DU_STATE_FROM_VALUE(DEFAULT_TEMP), DU_STATE_FROM_VALUE(DEFAULT_HUMI)}}};
+static_assert(SENSOR_PRIMARY == 0, "The compile-time filter default is set for the channel 0");
+
+/**
+ * @brief Trend engine of each sensor.
+ */
+PRIVATE DU_Trend DU_Trends[SENSOR_COUNT];
+
+/**
+ * @brief Outlier stage window of one sensor (raw values [0.01 C / 0.01 %], ring buffer).
+ */
+typedef struct {
+  SL tmpr[OUTLIER_COUNT];
+  SL humi[OUTLIER_COUNT];
+  UB idx;                 /* Write index */
+  UB count;               /* Number of valid samples (0..OUTLIER_COUNT) */
+} DU_Outlier;
+
+static_assert((OUTLIER_COUNT % 2) == 1, "OUTLIER_COUNT must be odd");
+static_assert(OUTLIER_MIN_COUNT <= OUTLIER_COUNT, "OUTLIER_MIN_COUNT exceeds the window");
+
+PRIVATE DU_Outlier DU_Outliers[SENSOR_COUNT];
+
+/**
+ * @brief Outlier stage statistics (all sensors).
+ */
+PRIVATE unsigned long DU_OutlierCount = 0;
+PRIVATE unsigned long DU_RangeErrorCount = 0;
+
+/**
+ * @brief Period of the AddTmprToTrendBuffer() calls [ms].
+ */
+PRIVATE unsigned long DU_TrendSampleTime = TREND_SAMPLE_TIME;
+
+/**
+ * @brief Length of the regression window [samples] (TREND_MIN_COUNT..TREND_COUNT).
+ */
+PRIVATE UW DU_TrendWindow = TREND_COUNT;
+
+/**
+ * @brief Smoothing factor (fraction) with the sample period it is defined for, the 
+ * period of the smoothing calls [ms] and the factor converted to it (precomputed).
+ * With the compile-time ALPHA at ALPHA_SAMPLE_TIME the compile-time factor 
+ * is used (DU_AlphaAdjusted false).
+ */
+PRIVATE UW DU_AlphaNum = ALPHA_NUM;
+PRIVATE UW DU_AlphaDen = ALPHA_DEN;
+PRIVATE unsigned long DU_AlphaSampleTime = ALPHA_SAMPLE_TIME;
+PRIVATE unsigned long DU_SmoothSampleTime = ALPHA_SAMPLE_TIME;
+PRIVATE bool DU_AlphaAdjusted = false;
+PRIVATE DU_Filter::Alpha DU_Alpha;
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Performs one smoothing step on one filter channel (native value type).
+ * @param filter The filter of the sensor.
+ * @param ch The channel index.
+ * @param raw The raw value.
+ * @return DU_Filter::Value The filtered value.
+ */
+PRIVATE DU_Filter::Value DU_Step(DU_Filter* filter, UB ch, DU_Filter::Value raw) {
+  return DU_AlphaAdjusted ? filter->RunAlpha(ch, raw, DU_Alpha) : filter->Run(ch, raw);
+}
+
+/**
+ * @brief Performs one smoothing step on all filter channels (native value type).
+ * @param filter The filter of the sensor.
+ * @param raw The raw values (DU_CHANNELS items).
+ * @param filtered Output for the filtered values (DU_CHANNELS items).
+ */
+PRIVATE void DU_StepAll(DU_Filter* filter, const DU_Filter::Value* raw, DU_Filter::Value* filtered) {
+  if (DU_AlphaAdjusted) {
+    filter->RunAllAlpha(raw, filtered, DU_Alpha);
+  } else {
+    filter->RunAll(raw, filtered);
+  }
+}
+
+/**
+ * @brief Converts a value in hundredths to the native value type of the filter.
+ * Both engines work in hundredths, the float one converts the integer exactly.
+ */
+PRIVATE DU_Filter::Value DU_ToFilter(SL value) {
+  return (DU_Filter::Value)value;
+}
+
+/**
+ * @brief Converts a native filter value to hundredths (the float engine rounds it).
+ */
+PRIVATE SL DU_FromFilter(DU_Filter::Value value) {
+#if (DU_FIXED_POINT == 1)
+  return value;
+#else
+  return QuantizeFx<0>(value);
+#endif
+}
+
+/**
+ * @brief Performs one smoothing step on one filter channel.
+ * @param filter The filter of the sensor.
+ * @param ch The channel index.
+ * @param raw The raw value in hundredths.
+ * @return SL The filtered value rounded to hundredths.
+ */
+PRIVATE SL DU_RunChannel(DU_Filter* filter, UB ch, SL raw) {
+  return DU_FromFilter(DU_Step(filter, ch, DU_ToFilter(raw)));
+}
+
+/**
+ * @brief Gets the filtered value of one channel from the filter state.
+ * @param filter The filter of the sensor.
+ * @param ch The channel index.
+ * @return SL The filtered value rounded to hundredths.
+ */
+PRIVATE SL DU_GetChannel(const DU_Filter* filter, UB ch) {
+  return DU_FromFilter(DU_Filter::Traits::ToValue(filter->state[ch]));
+}
+
+/**
+ * @brief Smooths temperature and humidity of one sensor in one pass over its filter state.
+ * @param filter The filter of the sensor.
+ * @param t_raw The raw temperature [0.01 C].
+ * @param h_raw The raw humidity [0.01 %].
+ * @param t_filt Output for the smoothed temperature [0.01 C].
+ * @param h_filt Output for the smoothed humidity [0.01 %].
  */
-PRIVATE float DU_TmprFiltered = DEFAULT_TEMP;
+PRIVATE void DU_RunBoth(DU_Filter* filter, SL t_raw, SL h_raw, SL* t_filt, SL* h_filt) {
+  DU_Filter::Value raw[DU_CHANNELS];
+  DU_Filter::Value filtered[DU_CHANNELS];
+
+  raw[DU_CH_TMPR] = DU_ToFilter(t_raw);
+  raw[DU_CH_HUMI] = DU_ToFilter(h_raw);
+  DU_StepAll(filter, raw, filtered);
+  *t_filt = DU_FromFilter(filtered[DU_CH_TMPR]);
+  *h_filt = DU_FromFilter(filtered[DU_CH_HUMI]);
+}
 
 /**
- * @brief Internal state variable for the Exponential Smoothing filter for humidity.
- * This variable is maintained between calls to Run_HumiSmooth().
+ * @brief Clears the trend buffer and the regression sums.
+ * @param trend The trend engine of the sensor.
  */
-PRIVATE float DU_HumiFiltered = DEFAULT_HUMI;
+PRIVATE void DU_ResetTrend(DU_Trend* trend) {
+  trend->idx = 0;
+  trend->count = 0;
+  trend->sumY = 0;
+  trend->sumXY = 0;
+}
 
 /**
- * @brief Circular buffer for storing temperature history for trend calculation.
+ * @brief Adds one sample to the trend buffer and updates the regression sums.
+ * When the buffer is full, the window slides: the oldest sample is removed 
+ * and the x of the others decreases by 1, so Sum(x*y) loses Sum(y) of the 
+ * remaining samples and gets (N-1)*y of the new one.
+ * @param trend The trend engine of the sensor.
+ * @param y The temperature [0.01 C].
  */
-PRIVATE float DU_TmprTrendBuffer[TREND_COUNT];
+PRIVATE void DU_AddTrendSample(DU_Trend* trend, SW y) {
+  if (trend->count < DU_TrendWindow) {
+    trend->sumXY += (long long)trend->count * y;
+    trend->sumY += y;
+    trend->count++;
+  } else {
+    SW oldest = trend->buffer[trend->idx];
+    trend->sumXY += (long long)(DU_TrendWindow - 1) * y - (trend->sumY - oldest);
+    trend->sumY += y - oldest;
+  }
+  trend->buffer[trend->idx] = y;
+  trend->idx = (trend->idx + 1) % DU_TrendWindow;
+}
 
 /**
- * @brief Index for writing into the circular buffer (points to the oldest value).
+ * @brief Gets the temperature rate of change (least-squares slope over the buffer).
+ * Slope = (n*Sxy - Sx*Sy) / (n*Sxx - Sx^2), with x = 0..n-1, so 
+ * Sx = n(n-1)/2 and n*Sxx - Sx^2 = n^2(n^2-1)/12 are known in closed form.
+ * @param trend The trend engine of the sensor.
+ * @return float The rate [C/h], 0 until TREND_MIN_COUNT samples are collected.
  */
-PRIVATE UB DU_TmprTrendBufferIdx = 0;
+PRIVATE float DU_GetTrendRate(const DU_Trend* trend) {
+  long long n = trend->count;
+
+  if (n < TREND_MIN_COUNT) {
+    return 0.0f;
+  }
+
+  long long sumX = (n * (n - 1)) / 2;
+  long long num = (n * trend->sumXY) - (sumX * trend->sumY);
+  long long den = (n * n * ((n * n) - 1)) / 12;
+
+  /* Slope [0.01 C / sample] -> [C / h] */
+  float slope = (float)num / (float)den;
+  return slope * DU_INV_POW10[DU_DECIMALS] * (3600000.0f / (float)DU_TrendSampleTime);
+}
+
+/**
+ * @brief Converts the smoothing factor to the period of the smoothing calls.
+ * alpha(dt) = 1 - (1 - a)^(dt / T), with the factor a defined for the period T.
+ */
+PRIVATE void DU_UpdateAlpha(void) {
+  float alpha = (float)DU_AlphaNum / DU_AlphaDen;
+
+  DU_AlphaAdjusted = ((DU_AlphaNum * (unsigned long)ALPHA_DEN) != ((unsigned long)ALPHA_NUM * DU_AlphaDen)) || 
+                     (DU_SmoothSampleTime != DU_AlphaSampleTime) || (DU_AlphaSampleTime != ALPHA_SAMPLE_TIME);
+  DU_Alpha = DU_Filter::Traits::AlphaFromFloat(1.0f - powf(1.0f - alpha, (float)DU_SmoothSampleTime / DU_AlphaSampleTime));
+}
+
+/**
+ * @brief Gets the median of a few values (insertion sort in place).
+ * @param values The values (reordered).
+ * @param n Number of the values.
+ * @return SL The median (upper one for an even n).
+ */
+PRIVATE SL DU_Median(SL* values, UB n) {
+  for (UB i = 1; i < n; i++) {
+    SL v = values[i];
+    UB k = i;
+    for (; (k > 0) && (values[k - 1] > v); k--) {
+      values[k] = values[k - 1];
+    }
+    values[k] = v;
+  }
+  return values[n / 2];
+}
+
+/**
+ * @brief Hampel test of the newest value of a window.
+ * @param window The window values (the newest one included).
+ * @param n Number of the values in the window.
+ * @param value In: the newest value, out: the median if it is an outlier.
+ * @param minLimit The lowest threshold (plausible change per sample).
+ * @return bool True if the value is an outlier.
+ */
+PRIVATE bool DU_IsOutlier(const SL* window, UB n, SL* value, SL minLimit) {
+  SL sorted[OUTLIER_COUNT];
+  SL dev[OUTLIER_COUNT];
+
+  for (UB i = 0; i < n; i++) {
+    sorted[i] = window[i];
+  }
+  SL median = DU_Median(sorted, n);
+  for (UB i = 0; i < n; i++) {
+    dev[i] = labs(window[i] - median);
+  }
+  /* 1.4826 * MAD ~ 3/2 * MAD (sigma of a normal distribution) */
+  SL limit = (OUTLIER_K * 3 * DU_Median(dev, n)) / 2;
+  if (limit < minLimit) {
+    limit = minLimit;
+  }
+  if (labs(*value - median) <= limit) {
+    return false;
+  }
+  *value = median;
+  return true;
+}
+
+/**
+ * @brief Classifies the trend rate.
+ * @param rate The rate [C/h].
+ * @return SB Returns 1 (rising), -1 (falling), or 0 (stable).
+ */
+PRIVATE SB DU_ClassifyTrend(float rate) {
+  if (rate > TREND_THRESHOLD) {
+    return 1; // Rising trend
+  } else if (rate < -TREND_THRESHOLD) {
+    return -1; // Falling trend
+  } else {
+    return 0; // Stable
+  }
+}
 
 // --------------------------------------------------------------------------
 // PUBLIC FUNCTIONS IMPLEMENTATION
@@ -49,118 +332,477 @@ PRIVATE UB DU_TmprTrendBufferIdx = 0;
 /**
  * @brief Initializes the internal filtered value for the temperature filter.
  * This should be called once, during setup(), after the sensor returns valid data.
- * @param t_init The initial (starting) temperature to set as the first stable value for the filter calculation.
+ * @param t_init The initial (starting) temperature to set as the first stable value for the filter calculation [0.01 C].
  */
-void Init_TmprSmooth(float t_init) {
-  DU_TmprFiltered = t_init;
+void Init_TmprSmooth(SL t_init) {
+  DU_Smooth[SENSOR_PRIMARY].Init(DU_CH_TMPR, DU_ToFilter(t_init));
 }
 
 /**
  * @brief Initializes the internal filtered value for the humidity filter.
  * This should be called once, during setup(), after the sensor returns valid data.
- * @param h_init The initial (starting) humidity to set as the first stable value for the filter calculation.
+ * @param h_init The initial (starting) humidity to set as the first stable value for the filter calculation [0.01 %].
  */
-void Init_HumiSmooth(float h_init) {
-  DU_HumiFiltered = h_init;
+void Init_HumiSmooth(SL h_init) {
+  DU_Smooth[SENSOR_PRIMARY].Init(DU_CH_HUMI, DU_ToFilter(h_init));
 }
 
 /**
  * @brief Initializes the circular trend buffer with an initial temperature value.
- * @param t_init The initial temperature to fill the buffer with.
+ * The window restarts with this one sample (no trend until TREND_MIN_COUNT samples).
+ * @param t_init The initial temperature to fill the buffer with [0.01 C].
+ */
+void Init_TmprTrendBuffer(SL t_init) {
+  Init_SensorTrend(SENSOR_PRIMARY, t_init);
+}
+
+/**
+ * @brief Sets the period of the AddTmprToTrendBuffer() calls (time base of the trend rate).
+ * @param sampleTime The sample period [ms].
+ */
+void SetTrendSampleTime(unsigned long sampleTime) {
+  if (sampleTime > 0) {
+    DU_TrendSampleTime = sampleTime;
+  }
+}
+
+/**
+ * @brief Sets the period of the smoothing calls, the smoothing factor is converted to it.
+ * alpha(dt) = 1 - (1 - ALPHA)^(dt / ALPHA_SAMPLE_TIME) keeps the time constant 
+ * of the filter, so the filtered value follows a change equally fast in 
+ * seconds at any sample period. The factor is computed here once per change 
+ * of the period, not per sample.
+ * @param sampleTime The sample period [ms].
+ */
+void SetSmoothSampleTime(unsigned long sampleTime) {
+  if ((sampleTime == 0) || (sampleTime == DU_SmoothSampleTime)) {
+    return;
+  }
+  DU_SmoothSampleTime = sampleTime;
+  DU_UpdateAlpha();
+}
+
+/**
+ * @brief Sets the smoothing factor (replaces the compile-time ALPHA, e.g. from the config).
+ * The hot path factor (Q0.16 with DU_FIXED_POINT) is precomputed here.
+ * @param alphaNum Numerator of the smoothing factor.
+ * @param alphaDen Denominator of the smoothing factor (alphaNum <= alphaDen).
+ * @param sampleTime The sample period the factor is defined for [ms].
+ * @return bool True if the factor was valid and applied.
+ */
+bool SetSmoothAlpha(UW alphaNum, UW alphaDen, unsigned long sampleTime) {
+  if ((0 == alphaNum) || (alphaNum > alphaDen) || (0 == sampleTime)) {
+    return false;
+  }
+  DU_AlphaNum = alphaNum;
+  DU_AlphaDen = alphaDen;
+  DU_AlphaSampleTime = sampleTime;
+  DU_UpdateAlpha();
+  return true;
+}
+
+/**
+ * @brief Sets the length of the regression window, the trend of all sensors restarts.
+ * Each window keeps its newest sample, so the rate is available again 
+ * after TREND_MIN_COUNT samples.
+ * @param window The window length [samples] (TREND_MIN_COUNT..TREND_COUNT).
+ * @return bool True if the length was valid and applied.
  */
-void Init_TmprTrendBuffer(float t_init) {
-  // Initialize the entire buffer with the starting temperature
-  for (UB i = 0; i < TREND_COUNT; i++) {
-    DU_TmprTrendBuffer[i] = t_init;
+bool SetTrendWindow(UW window) {
+  if ((window < TREND_MIN_COUNT) || (window > TREND_COUNT)) {
+    return false;
   }
+  if (window == DU_TrendWindow) {
+    return true;
+  }
+  SW newest[SENSOR_COUNT];
+  bool empty[SENSOR_COUNT];
+  for (UB i = 0; i < SENSOR_COUNT; i++) {
+    newest[i] = DU_Trends[i].buffer[(DU_Trends[i].idx + DU_TrendWindow - 1) % DU_TrendWindow];
+    empty[i] = (0 == DU_Trends[i].count);
+  }
+  DU_TrendWindow = window;
+  for (UB i = 0; i < SENSOR_COUNT; i++) {
+    DU_ResetTrend(&DU_Trends[i]);
+    if (!empty[i]) {
+      DU_AddTrendSample(&DU_Trends[i], newest[i]);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Gets the length of the regression window.
+ * @return UW The window length [samples], also the number of the used trend buffer entries.
+ */
+UW GetTrendWindow(void) {
+  return DU_TrendWindow;
+}
+
+/**
+ * @brief Performs Exponential Smoothing on raw temperature in hundredths.
+ * This function filters noise from raw measurements using the temperature 
+ * channel of the filter 'DU_Smooth' (which is private to DataUtils.cpp) 
+ * and the smoothing constant ALPHA. With DU_FIXED_POINT the integer math 
+ * keeps 16 fractional bits below 0.01 C, so the small ALPHA steps are not 
+ * lost by the rounding.
+ * @param rawValue The current raw measured temperature [0.01 C].
+ * @return SL The new, smoothed (filtered) temperature rounded to [0.01 C].
+ */
+SL Run_TmprSmooth(SL rawValue) {
+  return DU_RunChannel(&DU_Smooth[SENSOR_PRIMARY], DU_CH_TMPR, rawValue);
 }
 
 /**
- * @brief Performs Exponential Smoothing on raw sensor data.
- * This function filters noise from raw measurements using a global 
- * static variable 'DU_TmprFiltered' (which is private to DataUtils.cpp) 
- * and the smoothing constant ALPHA.
- * @param rawValue The current raw measured temperature value.
- * @return float The new, smoothed (filtered) value.
+ * @brief Performs Exponential Smoothing on raw humidity in hundredths.
+ * This function filters noise from raw humidity measurements using the 
+ * humidity channel of the filter 'DU_Smooth' and the smoothing constant ALPHA.
+ * @param rawValue The current raw measured humidity [0.01 %].
+ * @return SL The new, smoothed (filtered) humidity rounded to [0.01 %].
  */
-float Run_TmprSmooth(float rawValue) {
-  /* Formula: filtered = (ALPHA * New Raw) + ((1.0 - ALPHA) * Previous filtered) */
-  DU_TmprFiltered = (ALPHA * rawValue) + ((1.0 - ALPHA) * DU_TmprFiltered);
-  return DU_TmprFiltered;
+SL Run_HumiSmooth(SL rawValue) {
+  return DU_RunChannel(&DU_Smooth[SENSOR_PRIMARY], DU_CH_HUMI, rawValue);
+}
+
+/**
+ * @brief Performs Exponential Smoothing on temperature and humidity in one call.
+ * Both channels are updated in one pass over the filter state.
+ * @param t_raw The current raw measured temperature [0.01 C].
+ * @param h_raw The current raw measured humidity [0.01 %].
+ * @param t_filt Output for the smoothed temperature [0.01 C].
+ * @param h_filt Output for the smoothed humidity [0.01 %].
+ */
+void Run_TmprHumiSmooth(SL t_raw, SL h_raw, SL* t_filt, SL* h_filt) {
+  DU_RunBoth(&DU_Smooth[SENSOR_PRIMARY], t_raw, h_raw, t_filt, h_filt);
+}
+
+/**
+ * @brief Initializes the filter of one sensor (temperature and humidity).
+ * @param sensor The sensor (channel) index.
+ * @param t_init The initial temperature [0.01 C].
+ * @param h_init The initial humidity [0.01 %].
+ */
+void Init_SensorSmooth(UB sensor, SL t_init, SL h_init) {
+  if (sensor >= SENSOR_COUNT) {
+    return;
+  }
+  DU_Smooth[sensor].Init(DU_CH_TMPR, DU_ToFilter(t_init));
+  DU_Smooth[sensor].Init(DU_CH_HUMI, DU_ToFilter(h_init));
+}
+
+/**
+ * @brief Performs Exponential Smoothing on temperature and humidity of one sensor.
+ * Same as Run_TmprHumiSmooth() on the filter state of the given sensor.
+ * @param sensor The sensor (channel) index.
+ * @param t_raw The current raw measured temperature [0.01 C].
+ * @param h_raw The current raw measured humidity [0.01 %].
+ * @param t_filt Output for the smoothed temperature [0.01 C].
+ * @param h_filt Output for the smoothed humidity [0.01 %].
+ */
+void Run_SensorSmooth(UB sensor, SL t_raw, SL h_raw, SL* t_filt, SL* h_filt) {
+  if (sensor >= SENSOR_COUNT) {
+    return;
+  }
+  DU_RunBoth(&DU_Smooth[sensor], t_raw, h_raw, t_filt, h_filt);
 }
 
 /**
- * @brief Performs Exponential Smoothing on raw humidity sensor data.
- * This function filters noise from raw humidity measurements using a global
- * static variable 'DU_HumiFiltered' and the smoothing constant ALPHA.
- * @param rawValue The current raw measured humidity value.
- * @return float The new, smoothed (filtered) humidity value.
+ * @brief Gets the current filtered temperature (from the filter state).
+ * @return SL The filtered temperature rounded to [0.01 C].
  */
-float Run_HumiSmooth(float rawValue) {
-  /* Formula: filtered = (ALPHA * New Raw) + ((1.0 - ALPHA) * Previous filtered) */
-  DU_HumiFiltered = (ALPHA * rawValue) + ((1.0 - ALPHA) * DU_HumiFiltered);
-  return DU_HumiFiltered;
+SL GetTmprFiltered() {
+  return DU_GetChannel(&DU_Smooth[SENSOR_PRIMARY], DU_CH_TMPR);
+}
+
+/**
+ * @brief Gets the current filtered humidity (from the filter state).
+ * @return SL The filtered humidity rounded to [0.01 %].
+ */
+SL GetHumiFiltered() {
+  return DU_GetChannel(&DU_Smooth[SENSOR_PRIMARY], DU_CH_HUMI);
 }
 
 /**
  * @brief Adds a new temperature value to the circular buffer and advances the index.
- * @param newTmpr The new temperature value to store.
+ * The regression sums are updated incrementally, O(1) per sample.
+ * @param newTmpr The new temperature value to store [0.01 C].
  */
-void AddTmprToTrendBuffer(float newTmpr) {
-    // Store the new value at the current index (which is the oldest value)
-    DU_TmprTrendBuffer[DU_TmprTrendBufferIdx] = newTmpr;
-    // Advance index and wrap around (circular buffer logic)
-    DU_TmprTrendBufferIdx = (DU_TmprTrendBufferIdx + 1) % TREND_COUNT;
+void AddTmprToTrendBuffer(SL newTmpr) {
+  DU_AddTrendSample(&DU_Trends[SENSOR_PRIMARY], (SW)newTmpr);
 }
 
 /**
- * @brief Calculates the temperature trend by comparing the newest and oldest values in the buffer.
+ * @brief Calculates the temperature trend from the regression slope over the buffer.
+ * A single noisy sample changes the slope only by a small part.
  * @return SB Returns 1 (rising), -1 (falling), or 0 (stable).
  */
 SB GetTemperatureTrend() {
-  UB newestIdx;
-  // Index of the oldest value (where the next write will occur)
-  // Index where the next write will occur (points to the oldest value in the buffer)
-  UB nextWriteIdx = DU_TmprTrendBufferIdx; 
-
-  // The newest index is the one before the next write index in the circular buffer
-  if(0 == DU_TmprTrendBufferIdx) {
-    newestIdx = TREND_COUNT - 1;
-  } else {
-    newestIdx = DU_TmprTrendBufferIdx - 1;
+  return DU_ClassifyTrend(GetTmprTrendRate());
+}
+
+/**
+ * @brief Gets the temperature rate of change (least-squares slope over the buffer).
+ * @return float The rate [C/h], 0 until TREND_MIN_COUNT samples are collected.
+ */
+float GetTmprTrendRate() {
+  return DU_GetTrendRate(&DU_Trends[SENSOR_PRIMARY]);
+}
+
+/**
+ * @brief Restarts the trend window of one sensor with an initial temperature value.
+ * @param sensor The sensor (channel) index.
+ * @param t_init The initial temperature [0.01 C].
+ */
+void Init_SensorTrend(UB sensor, SL t_init) {
+  if (sensor >= SENSOR_COUNT) {
+    return;
+  }
+  DU_ResetTrend(&DU_Trends[sensor]);
+  DU_AddTrendSample(&DU_Trends[sensor], (SW)t_init);
+}
+
+/**
+ * @brief Adds a new temperature value to the trend buffer of one sensor (O(1)).
+ * @param sensor The sensor (channel) index.
+ * @param newTmpr The new temperature value to store [0.01 C].
+ */
+void AddSensorTmprToTrend(UB sensor, SL newTmpr) {
+  if (sensor >= SENSOR_COUNT) {
+    return;
   }
-  
-  float oldestTemp = DU_TmprTrendBuffer[nextWriteIdx];
-  float newestTemp = DU_TmprTrendBuffer[newestIdx];
+  DU_AddTrendSample(&DU_Trends[sensor], (SW)newTmpr);
+}
 
-  if (newestTemp > oldestTemp + TREND_THRESHOLD) {
-    return 1; // Rising trend
-  } else if (newestTemp < oldestTemp - TREND_THRESHOLD) {
-    return -1; // Falling trend
-  } else {
-    return 0; // Stable
+/**
+ * @brief Calculates the temperature trend of one sensor.
+ * @param sensor The sensor (channel) index.
+ * @return SB Returns 1 (rising), -1 (falling), or 0 (stable).
+ */
+SB GetSensorTrend(UB sensor) {
+  return DU_ClassifyTrend(GetSensorTrendRate(sensor));
+}
+
+/**
+ * @brief Gets the temperature rate of change of one sensor.
+ * @param sensor The sensor (channel) index.
+ * @return float The rate [C/h], 0 until TREND_MIN_COUNT samples are collected (or bad index).
+ */
+float GetSensorTrendRate(UB sensor) {
+  if (sensor >= SENSOR_COUNT) {
+    return 0.0f;
   }
+  return DU_GetTrendRate(&DU_Trends[sensor]);
+}
+
+/**
+ * @brief Gets the next sample period of the adaptive sampling from the signal activity.
+ * A fast change (large residual or trend rate) drops the period to 
+ * ADAPT_MIN_TIME at once; a stable signal doubles it up to ADAPT_MAX_TIME; 
+ * in between a longer period than ADAPT_BASE_TIME is cut to it, a shorter 
+ * one is kept (hysteresis, no toggling at the thresholds).
+ * @param sampleTime The current sample period [ms].
+ * @param residual The raw minus the filtered temperature of the last sample [0.01 C].
+ * @return unsigned long The next sample period [ms] (ADAPT_MIN_TIME..ADAPT_MAX_TIME).
+ */
+unsigned long GetAdaptiveSampleTime(unsigned long sampleTime, SL residual) {
+  float rate = fabsf(GetTmprTrendRate());
+
+  residual = labs(residual);
+  if ((residual >= ADAPT_FAST_RESIDUAL) || (rate >= ADAPT_FAST_RATE)) {
+    return ADAPT_MIN_TIME;
+  }
+  if ((residual <= ADAPT_STABLE_RESIDUAL) && (rate <= TREND_THRESHOLD)) {
+    sampleTime *= 2;
+  } else if (sampleTime > ADAPT_BASE_TIME) {
+    sampleTime = ADAPT_BASE_TIME;
+  }
+
+  if (sampleTime < ADAPT_MIN_TIME) {
+    return ADAPT_MIN_TIME;
+  }
+  return (sampleTime > ADAPT_MAX_TIME) ? ADAPT_MAX_TIME : sampleTime;
+}
+
+/**
+ * @brief Checks a raw sample of one sensor for range errors and outliers (before the smoothing).
+ * One corrupted read (passing the CRC) would otherwise pull the filtered 
+ * value for minutes (ALPHA = 0.03). A sample out of the sensor range is 
+ * rejected and not added to the window; an outlier is replaced by the 
+ * window median, the raw value stays in the window (a real step wins 
+ * once it holds for the majority of the window). The plausible change 
+ * follows the period of the smoothing calls (SetSmoothSampleTime()).
+ * @param sensor The sensor (channel) index.
+ * @param tmpr In: the raw temperature, out: the accepted value (median if an outlier) [0.01 C].
+ * @param hum In: the raw humidity, out: the accepted value (median if an outlier) [0.01 %].
+ * @return UB DU_FAULT_xxx flags (DU_FAULT_RANGE: the sample must not be used).
+ */
+UB RejectSensorOutliers(UB sensor, SL* tmpr, SL* hum) {
+  SL t = *tmpr;
+  SL h = *hum;
+  UB faults = DU_FAULT_NONE;
+
+  if ((sensor >= SENSOR_COUNT) || (t < OUTLIER_TMPR_MIN) || (t > OUTLIER_TMPR_MAX) ||
+      (h < OUTLIER_HUMI_MIN) || (h > OUTLIER_HUMI_MAX)) {
+    DU_RangeErrorCount++;
+    return DU_FAULT_RANGE;
+  }
+
+  DU_Outlier* window = &DU_Outliers[sensor];
+  window->tmpr[window->idx] = t;
+  window->humi[window->idx] = h;
+  window->idx = (window->idx + 1) % OUTLIER_COUNT;
+  if (window->count < OUTLIER_COUNT) {
+    window->count++;
+  }
+  if (window->count < OUTLIER_MIN_COUNT) {
+    return DU_FAULT_NONE;
+  }
+
+  /* Ring order does not matter for the median */
+  SL dt = (SL)((DU_SmoothSampleTime + 500UL) / 1000UL); /* [s] */
+  if (dt < 1) {
+    dt = 1;
+  }
+  if (DU_IsOutlier(window->tmpr, window->count, &t, OUTLIER_TMPR_RATE * dt)) {
+    *tmpr = t;
+    faults |= DU_FAULT_TMPR;
+    DU_OutlierCount++;
+  }
+  if (DU_IsOutlier(window->humi, window->count, &h, OUTLIER_HUMI_RATE * dt)) {
+    *hum = h;
+    faults |= DU_FAULT_HUMI;
+    DU_OutlierCount++;
+  }
+  return faults;
+}
+
+/**
+ * @brief Gets the number of the values replaced by the outlier stage (all sensors).
+ * @return unsigned long The number of the outliers.
+ */
+unsigned long GetOutlierCount() {
+  return DU_OutlierCount;
+}
+
+/**
+ * @brief Gets the number of the samples rejected as out of the sensor range (all sensors).
+ * @return unsigned long The number of the rejected samples.
+ */
+unsigned long GetRangeErrorCount() {
+  return DU_RangeErrorCount;
 }
 
 /**
  * @brief Gets a constant pointer to the internal temperature trend buffer.
- * @return const float* A read-only pointer to the circular buffer array.
+ * @return const SW* A read-only pointer to the circular buffer array [0.01 C].
+ */
+const SW* GetTmprTrendBuffer() {
+  return DU_Trends[SENSOR_PRIMARY].buffer;
+}
+
+/**
+ * @brief Copies the internal state (filters and the newest trend samples) to a snapshot.
+ * Only the primary sensor is kept (the RTC memory is limited).
+ * @param state Output snapshot.
+ */
+void GetDataUtilsState(DU_State* state) {
+  const DU_Trend* trend = &DU_Trends[SENSOR_PRIMARY];
+  UW count = (trend->count < TREND_SNAPSHOT_COUNT) ? trend->count : TREND_SNAPSHOT_COUNT;
+  /* Oldest of the copied samples */
+  UW idx = (trend->idx + DU_TrendWindow - count) % DU_TrendWindow;
+
+  state->filter = DU_Smooth[SENSOR_PRIMARY];
+  for (UB i = 0; i < count; i++) {
+    state->tmprTrendTail[i] = trend->buffer[idx];
+    idx = (idx + 1) % DU_TrendWindow;
+  }
+  for (UB i = count; i < TREND_SNAPSHOT_COUNT; i++) {
+    state->tmprTrendTail[i] = 0;
+  }
+  state->tmprTrendTailCount = (UB)count;
+  state->version = DU_STATE_VERSION;
+  state->size = (UB)sizeof(DU_State);
+}
+
+/**
+ * @brief Restores the internal state (filters and trend buffer) from a snapshot.
+ * The trend window is rebuilt from the stored samples.
+ * The snapshot is rejected if its layout (version, size) differs or the 
+ * sample count is out of range.
+ * @param state The snapshot created by GetDataUtilsState().
+ * @return bool True if the snapshot was valid and applied.
  */
-const float* GetTmprTrendBuffer() {
-  return DU_TmprTrendBuffer;
+bool SetDataUtilsState(const DU_State* state) {
+  if ((DU_STATE_VERSION != state->version) || (sizeof(DU_State) != state->size) ||
+      (state->tmprTrendTailCount > TREND_SNAPSHOT_COUNT)) {
+    return false;
+  }
+  DU_Smooth[SENSOR_PRIMARY] = state->filter;
+  DU_ResetTrend(&DU_Trends[SENSOR_PRIMARY]);
+  for (UB i = 0; i < state->tmprTrendTailCount; i++) {
+    DU_AddTrendSample(&DU_Trends[SENSOR_PRIMARY], state->tmprTrendTail[i]);
+  }
+  return true;
+}
+
+/**
+ * @brief Copies the outlier stage windows of all sensors to a snapshot.
+ * The raw values are in the sensor range, so they fit into SW.
+ * @param state Output snapshot.
+ */
+void GetOutlierState(DU_OutlierState* state) {
+  for (UB s = 0; s < SENSOR_COUNT; s++) {
+    const DU_Outlier* window = &DU_Outliers[s];
+    for (UB i = 0; i < OUTLIER_COUNT; i++) {
+      state->tmpr[s][i] = (SW)window->tmpr[i];
+      state->humi[s][i] = (SW)window->humi[i];
+    }
+    state->idx[s] = window->idx;
+    state->count[s] = window->count;
+  }
+  state->version = DU_OUTLIER_STATE_VERSION;
+  state->size = (UB)sizeof(DU_OutlierState);
+}
+
+/**
+ * @brief Restores the outlier stage windows of all sensors from a snapshot.
+ * The snapshot is rejected if its layout (version, size) differs or an 
+ * index or count is out of range.
+ * @param state The snapshot created by GetOutlierState().
+ * @return bool True if the snapshot was valid and applied.
+ */
+bool SetOutlierState(const DU_OutlierState* state) {
+  if ((DU_OUTLIER_STATE_VERSION != state->version) || (sizeof(DU_OutlierState) != state->size)) {
+    return false;
+  }
+  for (UB s = 0; s < SENSOR_COUNT; s++) {
+    if ((state->idx[s] >= OUTLIER_COUNT) || (state->count[s] > OUTLIER_COUNT)) {
+      return false;
+    }
+  }
+  for (UB s = 0; s < SENSOR_COUNT; s++) {
+    DU_Outlier* window = &DU_Outliers[s];
+    for (UB i = 0; i < OUTLIER_COUNT; i++) {
+      window->tmpr[i] = state->tmpr[s][i];
+      window->humi[i] = state->humi[s][i];
+    }
+    window->idx = state->idx[s];
+    window->count = state->count[s];
+  }
+  return true;
 }
 
 /**
 * @brief Rounds a float value to a specific number of decimal places.
 * This is used to limit the precision of raw sensor data early in the process.
+* Runtime variant of Quantize<PLACES>() (places above the table are limited).
 * @param value The float value to round.
 * @param places The number of decimal places (e.g., 2).
 * @return float The rounded value.
 */
 float RoundToDecimals(float value, UB places) {
-  float multiplier = 1.0;
-  for (UB i = 0; i < places; i++) {
-    multiplier *= 10.0;
+  if (places >= DU_POW10_COUNT) {
+    places = DU_POW10_COUNT - 1;
   }
-  return round(value * multiplier) / multiplier;
+  return roundf(value * DU_POW10[places]) * DU_INV_POW10[places];
 }
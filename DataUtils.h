@@ -3,6 +3,8 @@
  * @brief Header file for data processing utility functions.
  * This file contains function declarations and constants for smoothing 
  * sensor data, primarily using the Exponential Smoothing method.
+ * Each sensor (SENSOR_COUNT) has its own filter state and trend engine, 
+ * the functions without the sensor parameter work on SENSOR_PRIMARY.
  * @author Jan Olajec
  * @date 23.10.2025
  * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
@@ -16,6 +18,8 @@
 // INCLUDES
 // --------------------------------------------------------------------------
 #include "Global.h"
+#include "FilterUtils.h" /* Generic Exponential Smoothing filter */
+#include <math.h> /* lroundf(), roundf(), powf() */
 
 // --------------------------------------------------------------------------
 // CONSTANTS
@@ -36,18 +40,176 @@
  * * A lower value (closer to 0) results in stronger smoothing 
  * (more historical data influence), while a higher value (closer to 1) 
  * results in weaker smoothing (more current raw data influence).
+ * Defined as a fraction ALPHA_NUM / ALPHA_DEN (compile-time filter parameter).
  */
-#define ALPHA 0.03
+#define ALPHA_NUM 3
+#define ALPHA_DEN 100
+#define ALPHA ((float)ALPHA_NUM / ALPHA_DEN)
 
 /**
- * @brief Number of measurements stored in the circular trend buffer.
+ * @brief Sample period the smoothing factor ALPHA is designed for [ms].
+ * For another period (see SetSmoothSampleTime()) the factor is converted, 
+ * so the time constant of the filter stays the same (~197 s).
  */
-#define TREND_COUNT 10
+#define ALPHA_SAMPLE_TIME 6000
 
 /**
- * @brief The threshold (in degrees Celsius) used to define a temperature trend change.
+ * @brief Selection of the filter engine.
+ * 0 - Floating-point engine (single precision float), the default.
+ * 1 - Fixed-point engine: state in Q16.16 hundredths (int32), integer math only.
+ * The engines are not bit-identical: on the replay trace the filtered 
+ * values differ by up to 0.01 on some samples (rounding of the state), 
+ * so the fixed-point engine stays opt-in.
+ * The host replay tool builds both engines by -DDU_FIXED_POINT=x.
  */
-#define TREND_THRESHOLD 0.1
+#ifndef DU_FIXED_POINT
+#define DU_FIXED_POINT 0
+#endif
+
+/**
+ * @brief Channels of the DataUtils filter.
+ */
+#define DU_CH_TMPR 0 /* Temperature */
+#define DU_CH_HUMI 1 /* Humidity */
+#define DU_CHANNELS 2
+
+/**
+ * @brief Number of decimal places of the processed values (resolution 0.01).
+ * The fixed-point values (filter, MQTT) are integers in these units (hundredths).
+ */
+#define DU_DECIMALS 2
+
+/**
+ * @brief Powers of ten and their reciprocals for the quantizer (index = decimal places).
+ * The sample path keeps the values in integer 10^-DU_DECIMALS units up to the 
+ * formatters, so the reciprocal is used only at the output edge (FromFx()).
+ */
+constexpr float DU_POW10[] = {1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f};
+constexpr float DU_INV_POW10[] = {1.0f, 0.1f, 0.01f, 0.001f, 0.0001f};
+#define DU_POW10_COUNT (sizeof(DU_POW10) / sizeof(DU_POW10[0]))
+
+/**
+ * @brief Number of measurements stored in the circular trend buffer (regression window).
+ * 360 samples = 36 min at the 6 s sample period.
+ */
+#define TREND_COUNT 360
+
+/**
+ * @brief Minimal number of samples in the window before a trend is reported.
+ */
+#define TREND_MIN_COUNT 10
+
+/**
+ * @brief The threshold (rate of change in degrees Celsius per hour) used to define a temperature trend.
+ */
+#define TREND_THRESHOLD 0.5
+
+/**
+ * @brief Default period of the AddTmprToTrendBuffer() calls [ms] (see SetTrendSampleTime()).
+ */
+#define TREND_SAMPLE_TIME 6000
+
+/**
+ * @brief Number of the newest trend samples kept in the state snapshot.
+ * The whole window does not fit into the RTC memory, so after a restore 
+ * (deep sleep) the regression continues from these samples only.
+ */
+#define TREND_SNAPSHOT_COUNT 20
+
+/**
+ * @brief Layout version of DU_State, increment on any change of DU_State or DU_Filter.
+ * A snapshot of another version (e.g. written by the firmware before an OTA 
+ * update) is rejected by SetDataUtilsState(), also if its size is the same.
+ */
+#define DU_STATE_VERSION 2
+
+/**
+ * @brief Layout version of DU_OutlierState, increment on any change of DU_OutlierState.
+ */
+#define DU_OUTLIER_STATE_VERSION 1
+
+/**
+ * @brief Adaptive sample period limits and thresholds (see GetAdaptiveSampleTime()).
+ * The residual is the difference between the raw and the filtered temperature.
+ */
+#define ADAPT_MIN_TIME 1000         /* Period during a fast change [ms] */
+#define ADAPT_BASE_TIME 6000        /* Period during a moderate change [ms] */
+#define ADAPT_MAX_TIME 60000        /* Longest period of a stable signal [ms] */
+#define ADAPT_FAST_RATE 2.0         /* |Trend rate| of a fast change [C/h] */
+#define ADAPT_FAST_RESIDUAL 30      /* |Residual| of a fast change [0.01 C] */
+#define ADAPT_STABLE_RESIDUAL 10    /* Max. |residual| of a stable signal [0.01 C] (and |rate| <= TREND_THRESHOLD) */
+
+/**
+ * @brief Outlier stage ahead of the smoothing (see RejectSensorOutliers()).
+ * Hampel test over the newest OUTLIER_COUNT raw samples: a value further 
+ * than OUTLIER_K sigma (1.4826 * MAD) from the window median is replaced 
+ * by the median. The threshold is never below the plausible rate of 
+ * change times the sample period, so the quantized, nearly constant 
+ * signal (MAD = 0) does not reject normal steps. A true step is accepted 
+ * when it holds for the majority of the window.
+ */
+#define OUTLIER_COUNT 5            /* Window length [samples] (odd) */
+#define OUTLIER_MIN_COUNT 3        /* Samples needed for the test (median-of-3) */
+#define OUTLIER_K 3                /* Threshold [MAD sigma] */
+#define OUTLIER_TMPR_RATE 20       /* Max. plausible temperature rate [0.01 C/s] */
+#define OUTLIER_HUMI_RATE 200      /* Max. plausible humidity rate [0.01 %/s] */
+
+/**
+ * @brief Measurement range of the SHT31 [0.01 C / 0.01 %], values outside are rejected.
+ */
+#define OUTLIER_TMPR_MIN -4000
+#define OUTLIER_TMPR_MAX 12500
+#define OUTLIER_HUMI_MIN 0
+#define OUTLIER_HUMI_MAX 10000
+
+/**
+ * @brief Result flags of RejectSensorOutliers().
+ */
+#define DU_FAULT_NONE 0x00 /* Sample accepted as is */
+#define DU_FAULT_RANGE 0x01 /* Value out of the sensor range, sample rejected */
+#define DU_FAULT_TMPR 0x02 /* Temperature outlier, replaced by the median */
+#define DU_FAULT_HUMI 0x04 /* Humidity outlier, replaced by the median */
+
+// --------------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Type of the DataUtils filter (depends on DU_FIXED_POINT).
+ */
+#if (DU_FIXED_POINT == 1)
+typedef ExpSmoothFilter<SL, ALPHA_NUM, ALPHA_DEN, DU_CHANNELS> DU_Filter; /* Values in hundredths */
+#else
+typedef ExpSmoothFilter<float, ALPHA_NUM, ALPHA_DEN, DU_CHANNELS> DU_Filter; /* Values in hundredths */
+#endif
+
+/**
+ * @brief Snapshot of the internal state (filters and trend buffer) of the primary sensor.
+ * Used to persist the state over deep sleep or reboot, so the smoothing 
+ * and the trend continue instead of being reset by Init_TmprSmooth().
+ */
+typedef struct {
+  DU_Filter filter;                        /* Filter state of all channels */
+  SW tmprTrendTail[TREND_SNAPSHOT_COUNT];  /* Newest trend samples [0.01 C], oldest first */
+  UB tmprTrendTailCount;                   /* Number of valid samples in tmprTrendTail */
+  UB version;                              /* DU_STATE_VERSION */
+  UB size;                                 /* sizeof(DU_State) */
+} DU_State;
+
+/**
+ * @brief Snapshot of the outlier stage windows of all sensors.
+ * A separate record (DU_State is at the RTC record limit): in the deep 
+ * sleep mode every wake-up adds one sample, so without it the window 
+ * would never reach OUTLIER_MIN_COUNT and the Hampel test would not run.
+ */
+typedef struct {
+  SW tmpr[SENSOR_COUNT][OUTLIER_COUNT];    /* Raw temperatures [0.01 C] (ring buffer) */
+  SW humi[SENSOR_COUNT][OUTLIER_COUNT];    /* Raw humidities [0.01 %] (ring buffer) */
+  UB idx[SENSOR_COUNT];                    /* Write index */
+  UB count[SENSOR_COUNT];                  /* Number of valid samples (0..OUTLIER_COUNT) */
+  UB version;                              /* DU_OUTLIER_STATE_VERSION */
+  UB size;                                 /* sizeof(DU_OutlierState) */
+} DU_OutlierState;
 
 // --------------------------------------------------------------------------
 // PUBLIC FUNCTION PROTOTYPE
@@ -55,53 +217,215 @@
 
 /**
  * @brief Initializes the internal filtered value for the Exponential Smoothing filter.
- * @param t_init The initial (starting) temperature to set as the first stable value.
+ * @param t_init The initial (starting) temperature to set as the first stable value [0.01 C].
  */
-void Init_TmprSmooth(float t_init);
+void Init_TmprSmooth(SL t_init);
 
 /**
  * @brief Initializes the internal filtered value for the Exponential Smoothing filter for humidity.
- * @param h_init The initial (starting) humidity to set as the first stable value.
+ * @param h_init The initial (starting) humidity to set as the first stable value [0.01 %].
+ */
+void Init_HumiSmooth(SL h_init);
+
+/**
+ * @brief Sets the period of the smoothing calls, the smoothing factor is converted to it.
+ * @param sampleTime The sample period [ms].
+ */
+void SetSmoothSampleTime(unsigned long sampleTime);
+
+/**
+ * @brief Sets the smoothing factor (replaces the compile-time ALPHA, e.g. from the config).
+ * @param alphaNum Numerator of the smoothing factor.
+ * @param alphaDen Denominator of the smoothing factor (alphaNum <= alphaDen).
+ * @param sampleTime The sample period the factor is defined for [ms].
+ * @return bool True if the factor was valid and applied.
+ */
+bool SetSmoothAlpha(UW alphaNum, UW alphaDen, unsigned long sampleTime);
+
+/**
+ * @brief Sets the length of the regression window, the trend of all sensors restarts.
+ * @param window The window length [samples] (TREND_MIN_COUNT..TREND_COUNT).
+ * @return bool True if the length was valid and applied.
+ */
+bool SetTrendWindow(UW window);
+
+/**
+ * @brief Gets the length of the regression window.
+ * @return UW The window length [samples].
+ */
+UW GetTrendWindow(void);
+
+/**
+ * @brief Performs Exponential Smoothing on raw temperature in hundredths.
+ * @param rawValue The current raw measured temperature [0.01 C].
+ * @return SL The new, smoothed (filtered) temperature rounded to [0.01 C].
  */
-void Init_HumiSmooth(float h_init);
+SL Run_TmprSmooth(SL rawValue);
 
 /**
- * @brief Performs Exponential Smoothing on raw sensor data.
- * @param rawValue The current raw measured temperature value.
- * @return float The new, smoothed (filtered) value.
+ * @brief Performs Exponential Smoothing on raw humidity in hundredths.
+ * @param rawValue The current raw measured humidity [0.01 %].
+ * @return SL The new, smoothed (filtered) humidity rounded to [0.01 %].
  */
-float Run_TmprSmooth(float rawValue);
+SL Run_HumiSmooth(SL rawValue);
 
 /**
- * @brief Performs Exponential Smoothing on raw humidity data.
- * @param rawValue The current raw measured humidity value.
- * @return float The new, smoothed (filtered) humidity value.
+ * @brief Performs Exponential Smoothing on temperature and humidity in one call.
+ * @param t_raw The current raw measured temperature [0.01 C].
+ * @param h_raw The current raw measured humidity [0.01 %].
+ * @param t_filt Output for the smoothed temperature [0.01 C].
+ * @param h_filt Output for the smoothed humidity [0.01 %].
  */
-float Run_HumiSmooth(float rawValue);
+void Run_TmprHumiSmooth(SL t_raw, SL h_raw, SL* t_filt, SL* h_filt);
+
+/**
+ * @brief Initializes the filter of one sensor (temperature and humidity).
+ * @param sensor The sensor (channel) index.
+ * @param t_init The initial temperature [0.01 C].
+ * @param h_init The initial humidity [0.01 %].
+ */
+void Init_SensorSmooth(UB sensor, SL t_init, SL h_init);
+
+/**
+ * @brief Performs Exponential Smoothing on temperature and humidity of one sensor.
+ * @param sensor The sensor (channel) index.
+ * @param t_raw The current raw measured temperature [0.01 C].
+ * @param h_raw The current raw measured humidity [0.01 %].
+ * @param t_filt Output for the smoothed temperature [0.01 C].
+ * @param h_filt Output for the smoothed humidity [0.01 %].
+ */
+void Run_SensorSmooth(UB sensor, SL t_raw, SL h_raw, SL* t_filt, SL* h_filt);
+
+/**
+ * @brief Gets the current filtered temperature (from the filter state).
+ * @return SL The filtered temperature rounded to [0.01 C].
+ */
+SL GetTmprFiltered(void);
+
+/**
+ * @brief Gets the current filtered humidity (from the filter state).
+ * @return SL The filtered humidity rounded to [0.01 %].
+ */
+SL GetHumiFiltered(void);
 
 /**
  * @brief Initializes the circular trend buffer with an initial temperature value.
- * @param t_init The initial temperature to fill the buffer with.
+ * @param t_init The initial temperature to fill the buffer with [0.01 C].
  */
-void Init_TmprTrendBuffer(float t_init);
+void Init_TmprTrendBuffer(SL t_init);
 
 /**
- * @brief Adds a new temperature value to the circular buffer and advances the index.
- * @param newTmpr The new temperature value to store.
+ * @brief Sets the period of the AddTmprToTrendBuffer() calls (time base of the trend rate).
+ * @param sampleTime The sample period [ms].
  */
-void AddTmprToTrendBuffer(float newTmpr);
+void SetTrendSampleTime(unsigned long sampleTime);
 
 /**
- * @brief Calculates the temperature trend by comparing the newest and oldest values in the buffer.
+ * @brief Adds a new temperature value to the circular buffer and updates the regression sums (O(1)).
+ * @param newTmpr The new temperature value to store [0.01 C].
+ */
+void AddTmprToTrendBuffer(SL newTmpr);
+
+/**
+ * @brief Calculates the temperature trend from the regression slope over the buffer.
  * @return SB Returns 1 (rising), -1 (falling), or 0 (stable).
  */
 SB GetTemperatureTrend(void);
 
+/**
+ * @brief Gets the temperature rate of change (least-squares slope over the buffer).
+ * @return float The rate [C/h], 0 until TREND_MIN_COUNT samples are collected.
+ */
+float GetTmprTrendRate(void);
+
+/**
+ * @brief Restarts the trend window of one sensor with an initial temperature value.
+ * @param sensor The sensor (channel) index.
+ * @param t_init The initial temperature [0.01 C].
+ */
+void Init_SensorTrend(UB sensor, SL t_init);
+
+/**
+ * @brief Adds a new temperature value to the trend buffer of one sensor (O(1)).
+ * @param sensor The sensor (channel) index.
+ * @param newTmpr The new temperature value to store [0.01 C].
+ */
+void AddSensorTmprToTrend(UB sensor, SL newTmpr);
+
+/**
+ * @brief Calculates the temperature trend of one sensor.
+ * @param sensor The sensor (channel) index.
+ * @return SB Returns 1 (rising), -1 (falling), or 0 (stable).
+ */
+SB GetSensorTrend(UB sensor);
+
+/**
+ * @brief Gets the temperature rate of change of one sensor.
+ * @param sensor The sensor (channel) index.
+ * @return float The rate [C/h], 0 until TREND_MIN_COUNT samples are collected.
+ */
+float GetSensorTrendRate(UB sensor);
+
+/**
+ * @brief Gets the next sample period of the adaptive sampling from the signal activity.
+ * @param sampleTime The current sample period [ms].
+ * @param residual The raw minus the filtered temperature of the last sample [0.01 C].
+ * @return unsigned long The next sample period [ms] (ADAPT_MIN_TIME..ADAPT_MAX_TIME).
+ */
+unsigned long GetAdaptiveSampleTime(unsigned long sampleTime, SL residual);
+
+/**
+ * @brief Checks a raw sample of one sensor for range errors and outliers (before the smoothing).
+ * @param sensor The sensor (channel) index.
+ * @param tmpr In: the raw temperature, out: the accepted value (median if an outlier) [0.01 C].
+ * @param hum In: the raw humidity, out: the accepted value (median if an outlier) [0.01 %].
+ * @return UB DU_FAULT_xxx flags (DU_FAULT_RANGE: the sample must not be used).
+ */
+UB RejectSensorOutliers(UB sensor, SL* tmpr, SL* hum);
+
+/**
+ * @brief Gets the number of the values replaced by the outlier stage (all sensors).
+ * @return unsigned long The number of the outliers.
+ */
+unsigned long GetOutlierCount(void);
+
+/**
+ * @brief Gets the number of the samples rejected as out of the sensor range (all sensors).
+ * @return unsigned long The number of the rejected samples.
+ */
+unsigned long GetRangeErrorCount(void);
+
 /**
  * @brief Gets a constant pointer to the internal temperature trend buffer.
- * @return const float* A read-only pointer to the circular buffer array.
+ * @return const SW* A read-only pointer to the circular buffer array [0.01 C].
+ */
+const SW* GetTmprTrendBuffer(void);
+
+/**
+ * @brief Copies the internal state (filters and trend buffer) to a snapshot.
+ * @param state Output snapshot.
+ */
+void GetDataUtilsState(DU_State* state);
+
+/**
+ * @brief Restores the internal state (filters and trend buffer) from a snapshot.
+ * @param state The snapshot created by GetDataUtilsState().
+ * @return bool True if the snapshot was valid and applied.
+ */
+bool SetDataUtilsState(const DU_State* state);
+
+/**
+ * @brief Copies the outlier stage windows of all sensors to a snapshot.
+ * @param state Output snapshot.
+ */
+void GetOutlierState(DU_OutlierState* state);
+
+/**
+ * @brief Restores the outlier stage windows of all sensors from a snapshot.
+ * @param state The snapshot created by GetOutlierState().
+ * @return bool True if the snapshot was valid and applied.
  */
-const float* GetTmprTrendBuffer(void);
+bool SetOutlierState(const DU_OutlierState* state);
 
 /**
 * @brief Rounds a float value to a specific number of decimal places.
@@ -111,4 +435,48 @@ const float* GetTmprTrendBuffer(void);
 */
 float RoundToDecimals(float value, UB places);
 
+// --------------------------------------------------------------------------
+// PUBLIC INLINE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Quantizes a float value to the fixed-point integer (e.g. PLACES = 2: 24.056 -> 2406).
+ * The scale is a compile-time constant, no loop and no division.
+ * @tparam PLACES The number of decimal places.
+ * @param value The float value to quantize.
+ * @return SL The value in 10^-PLACES units (rounded half away from zero).
+ */
+template <UB PLACES>
+inline SL QuantizeFx(float value) {
+  static_assert(PLACES < DU_POW10_COUNT, "PLACES out of the power-of-ten table");
+  return (SL)lroundf(value * DU_POW10[PLACES]);
+}
+
+/**
+ * @brief Converts the fixed-point integer back to float (e.g. PLACES = 2: 2406 -> 24.06).
+ * For the output edge only (display, serial and JSON formatters), one 
+ * multiplication. The reciprocal is not exact in float, the result may 
+ * be 1 ulp off the nearest float of the decimal value, which does not 
+ * change the text printed with PLACES decimals.
+ * @tparam PLACES The number of decimal places.
+ * @param fx The value in 10^-PLACES units.
+ * @return float The float value.
+ */
+template <UB PLACES>
+inline float FromFx(SL fx) {
+  static_assert(PLACES < DU_POW10_COUNT, "PLACES out of the power-of-ten table");
+  return (float)fx * DU_INV_POW10[PLACES];
+}
+
+/**
+ * @brief Rounds a float value to PLACES decimal places (compile-time RoundToDecimals()).
+ * @tparam PLACES The number of decimal places.
+ * @param value The float value to round.
+ * @return float The rounded value.
+ */
+template <UB PLACES>
+inline float Quantize(float value) {
+  return FromFx<PLACES>(QuantizeFx<PLACES>(value));
+}
+
 #endif // DATA_UTILS_H
\ No newline at end of file
@@ -0,0 +1,368 @@
+/**
+ * @file DisplayUtils.cpp
+ * @brief Implementation file for the partial (dirty region) refresh of the SSD1306 OLED.
+ * This file provides the definitions (logic) for the functions 
+ * declared in DisplayUtils.h.
+ * Frame buffer layout (SSD1306): 8 pages of 8 pixel rows, one byte per 
+ * column and page, bit 0 = top row of the page.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Wire.h>
+#include <string.h>
+#include "Global.h"
+#include "DisplayUtils.h"
+#include "BusUtils.h" /* Sensor priority on the shared bus */
+
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+#define DP_FONT_WIDTH 6 /* Classic font cell width incl. spacing [px] */
+#define DP_FONT_HEIGHT 8 /* Classic font cell height [px] */
+#define DP_CONTROL_CMD 0x00 /* Control byte: command stream */
+#define DP_CONTROL_DATA 0x40 /* Control byte: data stream */
+#define DP_NO_DIRTY 0xFF /* Page without changed columns */
+#define DP_NO_WINDOW 0xFF /* Display address window unknown */
+#define DP_NO_CACHE 0xFF /* Region without the glyph cache */
+#define DP_GLYPH_COUNT (sizeof(DISP_GLYPH_SET) - 1) /* Number of the cached characters */
+
+// --------------------------------------------------------------------------
+// PRIVATE TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief One text region and its currently rendered text.
+ */
+typedef struct {
+  int16_t x;
+  int16_t y;
+  UB size;                  /* Text scale */
+  UB maxChars;              /* Region width [characters] */
+  UB cache;                 /* Glyph cache index (DP_NO_CACHE = drawn by drawChar()) */
+  char text[DISP_TEXT_LEN]; /* Text in the frame buffer */
+} DP_Region;
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief The display and its I2C address.
+ */
+PRIVATE Adafruit_SSD1306* DP_Display = nullptr;
+PRIVATE UB DP_Address = 0;
+
+/**
+ * @brief Table of the registered regions.
+ */
+PRIVATE DP_Region DP_Regions[DISP_REGION_MAX];
+PRIVATE UB DP_RegionCount = 0;
+
+/**
+ * @brief One pre-rendered glyph set (all DISP_GLYPH_SET characters at one text size).
+ */
+typedef struct {
+  UB size;    /* Text scale */
+  UW offset;  /* Start of the glyphs in DP_GlyphData */
+} DP_GlyphCache;
+
+/**
+ * @brief Glyph sets and their data. One glyph is stored in the SSD1306 
+ * layout: 'size' pages of 6 * size column bytes.
+ */
+PRIVATE DP_GlyphCache DP_GlyphCaches[DISP_REGION_MAX];
+PRIVATE UB DP_GlyphCacheCount = 0;
+PRIVATE UW DP_GlyphUsed = 0;
+PRIVATE UB DP_GlyphData[DISP_GLYPH_CACHE_SIZE];
+
+/**
+ * @brief Changed column range per page (DP_NO_DIRTY = page unchanged).
+ */
+PRIVATE UB DP_DirtyFirst[8];
+PRIVATE UB DP_DirtyLast[8];
+
+/**
+ * @brief The address window set in the display and its next column.
+ * A resumed transfer continues without a new window command.
+ */
+PRIVATE UB DP_WinPage = DP_NO_WINDOW;
+PRIVATE UB DP_WinLast = 0;
+PRIVATE UB DP_WinNext = 0;
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Marks a rectangle of the frame buffer as changed (clipped to the screen).
+ */
+PRIVATE void DP_MarkDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+  int16_t x1 = x + w - 1;
+  int16_t y1 = y + h - 1;
+
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 >= DP_Display->width()) x1 = DP_Display->width() - 1;
+  if (y1 >= DP_Display->height()) y1 = DP_Display->height() - 1;
+  if ((x > x1) || (y > y1)) {
+    return;
+  }
+
+  for (int16_t page = y / 8; page <= y1 / 8; page++) {
+    if ((DP_NO_DIRTY == DP_DirtyFirst[page]) || (x < DP_DirtyFirst[page])) {
+      DP_DirtyFirst[page] = (UB)x;
+    }
+    if ((DP_NO_DIRTY == DP_DirtyLast[page]) || (x1 > DP_DirtyLast[page])) {
+      DP_DirtyLast[page] = (UB)x1;
+    }
+  }
+}
+
+/**
+ * @brief Gets the glyph set for a text size, renders it when it is not cached yet.
+ * The characters are drawn once by the GFX font scaling into a canvas and 
+ * converted to the page layout.
+ * @return UB The glyph cache index, or DP_NO_CACHE when the memory is full.
+ */
+PRIVATE UB DP_GetGlyphCache(UB size) {
+  for (UB i = 0; i < DP_GlyphCacheCount; i++) {
+    if (DP_GlyphCaches[i].size == size) {
+      return i;
+    }
+  }
+
+  int16_t cellW = DP_FONT_WIDTH * size;
+  UW glyphLen = (UW)cellW * size;
+  if ((DP_GlyphCacheCount >= DISP_REGION_MAX) || 
+      ((DP_GlyphUsed + (glyphLen * DP_GLYPH_COUNT)) > DISP_GLYPH_CACHE_SIZE)) {
+    return DP_NO_CACHE;
+  }
+
+  GFXcanvas1 canvas(cellW, DP_FONT_HEIGHT * size);
+  if (nullptr == canvas.getBuffer()) {
+    return DP_NO_CACHE; /* Out of heap */
+  }
+
+  UB* glyph = &DP_GlyphData[DP_GlyphUsed];
+  for (UB g = 0; g < DP_GLYPH_COUNT; g++) {
+    canvas.fillScreen(0);
+    canvas.drawChar(0, 0, (unsigned char)DISP_GLYPH_SET[g], 1, 0, size);
+    for (UB page = 0; page < size; page++) {
+      for (int16_t col = 0; col < cellW; col++) {
+        UB bits = 0;
+        for (UB bit = 0; bit < 8; bit++) {
+          if (canvas.getPixel(col, (page * 8) + bit)) {
+            bits |= (UB)(1u << bit);
+          }
+        }
+        *glyph++ = bits;
+      }
+    }
+  }
+
+  DP_GlyphCaches[DP_GlyphCacheCount].size = size;
+  DP_GlyphCaches[DP_GlyphCacheCount].offset = DP_GlyphUsed;
+  DP_GlyphUsed += glyphLen * DP_GLYPH_COUNT;
+  return DP_GlyphCacheCount++;
+}
+
+/**
+ * @brief Copies a cached glyph into the frame buffer (region y page-aligned).
+ * @return bool True if the character is cached and was copied, false to draw it by drawChar().
+ */
+PRIVATE bool DP_BlitGlyph(const DP_Region* region, int16_t x, char c) {
+  const char* found = (c != '\0') ? strchr(DISP_GLYPH_SET, c) : nullptr;
+  if ((DP_NO_CACHE == region->cache) || (nullptr == found) || (x < 0)) {
+    return false;
+  }
+
+  UB* buffer = DP_Display->getBuffer();
+  int16_t width = DP_Display->width();
+  int16_t cellW = DP_FONT_WIDTH * region->size;
+  int16_t copyW = ((x + cellW) > width) ? (width - x) : cellW;
+  UW glyphLen = (UW)cellW * region->size;
+  const UB* glyph = &DP_GlyphData[DP_GlyphCaches[region->cache].offset + ((found - DISP_GLYPH_SET) * glyphLen)];
+  int16_t firstPage = region->y / 8;
+
+  if (copyW <= 0) {
+    return false;
+  }
+  for (UB page = 0; (page < region->size) && ((firstPage + page) < (DP_Display->height() / 8)); page++) {
+    memcpy(&buffer[((firstPage + page) * width) + x], &glyph[page * cellW], copyW);
+  }
+  return true;
+}
+
+/**
+ * @brief Sends a command sequence in one I2C transmission.
+ */
+PRIVATE void DP_SendCommands(const UB* cmds, UB count) {
+  Wire.beginTransmission(DP_Address);
+  Wire.write((UB)DP_CONTROL_CMD);
+  Wire.write(cmds, count);
+  Wire.endTransmission();
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Connects the partial refresh to an initialized display.
+ * @param display The display (display.begin() already called).
+ * @param address The display I2C address.
+ */
+void Init_Display(Adafruit_SSD1306* display, UB address) {
+  DP_Display = display;
+  DP_Address = address;
+  DP_RegionCount = 0;
+  DP_GlyphCacheCount = 0;
+  DP_GlyphUsed = 0;
+  DP_WinPage = DP_NO_WINDOW;
+  memset(DP_DirtyFirst, DP_NO_DIRTY, sizeof(DP_DirtyFirst));
+  memset(DP_DirtyLast, DP_NO_DIRTY, sizeof(DP_DirtyLast));
+}
+
+/**
+ * @brief Registers a text region (one line of the classic 6x8 font).
+ * @param x Left edge [px].
+ * @param y Top edge [px].
+ * @param textSize Text scale (1 = 6x8 px per character).
+ * @param maxChars Region width [characters] (max. DISP_TEXT_LEN - 1).
+ * @return UB Region ID, or DISP_INVALID_REGION when the table is full.
+ */
+UB AddDisplayRegion(int16_t x, int16_t y, UB textSize, UB maxChars) {
+  if ((DP_RegionCount >= DISP_REGION_MAX) || (maxChars >= DISP_TEXT_LEN)) {
+    return DISP_INVALID_REGION;
+  }
+
+  DP_Region* region = &DP_Regions[DP_RegionCount];
+  region->x = x;
+  region->y = y;
+  region->size = textSize;
+  region->maxChars = maxChars;
+  region->cache = ((y % 8) == 0) ? DP_GetGlyphCache(textSize) : DP_NO_CACHE;
+  region->text[0] = '\0';
+  return DP_RegionCount++;
+}
+
+/**
+ * @brief Sets the text of a region, only the changed character cells are rendered.
+ * A changed character is copied from the glyph cache, or drawn with the 
+ * background color (the whole cell is overwritten), the cells behind 
+ * the end of a shorter text are cleared.
+ * @param id The region ID.
+ * @param text The new text (longer text is cut at the region width).
+ */
+void SetDisplayRegionText(UB id, const char* text) {
+  if ((nullptr == DP_Display) || (id >= DP_RegionCount)) {
+    return;
+  }
+
+  DP_Region* region = &DP_Regions[id];
+  int16_t cellW = DP_FONT_WIDTH * region->size;
+  int16_t cellH = DP_FONT_HEIGHT * region->size;
+  size_t oldLen = strlen(region->text);
+  size_t newLen = strlen(text);
+
+  if (newLen > region->maxChars) {
+    newLen = region->maxChars;
+  }
+
+  for (size_t i = 0; (i < newLen) || (i < oldLen); i++) {
+    char oldChar = (i < oldLen) ? region->text[i] : '\0';
+    char newChar = (i < newLen) ? text[i] : '\0';
+    int16_t x = region->x + (int16_t)(i * cellW);
+
+    if (oldChar == newChar) {
+      continue;
+    }
+    if ('\0' == newChar) {
+      DP_Display->fillRect(x, region->y, cellW, cellH, SSD1306_BLACK);
+    } else if (!DP_BlitGlyph(region, x, newChar)) {
+      DP_Display->drawChar(x, region->y, (unsigned char)newChar, SSD1306_WHITE, SSD1306_BLACK, region->size);
+    }
+    DP_MarkDirty(x, region->y, cellW, cellH);
+  }
+
+  memcpy(region->text, text, newLen);
+  region->text[newLen] = '\0';
+}
+
+/**
+ * @brief Sends the next part of the changed frame buffer to the display (nothing if unchanged).
+ * Each changed page is sent as a page/column window, the data in chunks 
+ * of DISP_I2C_CHUNK bytes. At most DISP_FLUSH_CHUNKS chunks are sent per 
+ * call and no chunk while the bus is reserved for the sensor, the rest 
+ * of the page stays dirty and is sent by the next call.
+ * @return bool True if the whole change is sent, false if a part is left for the next call.
+ */
+bool FlushDisplay() {
+  if (nullptr == DP_Display) {
+    return true;
+  }
+
+  const UB* buffer = DP_Display->getBuffer();
+  int16_t width = DP_Display->width();
+  UB chunks = 0;
+
+  for (UB page = 0; page < (DP_Display->height() / 8); page++) {
+    while (DP_NO_DIRTY != DP_DirtyFirst[page]) {
+      if ((chunks >= DISP_FLUSH_CHUNKS) || !IsBusFree()) {
+        return false;
+      }
+
+      UB first = DP_DirtyFirst[page];
+      UB last = DP_DirtyLast[page];
+      if ((page != DP_WinPage) || (first != DP_WinNext) || (last != DP_WinLast)) {
+        const UB window[] = {SSD1306_PAGEADDR, page, page, SSD1306_COLUMNADDR, first, last};
+        DP_SendCommands(window, sizeof(window));
+        DP_WinPage = page;
+        DP_WinLast = last;
+      }
+
+      UW count = (UW)(last - first) + 1;
+      UB chunk = (count < DISP_I2C_CHUNK) ? (UB)count : DISP_I2C_CHUNK;
+      Wire.beginTransmission(DP_Address);
+      Wire.write((UB)DP_CONTROL_DATA);
+      Wire.write(&buffer[(page * width) + first], chunk);
+      Wire.endTransmission();
+      chunks++;
+
+      if (chunk == count) {
+        DP_DirtyFirst[page] = DP_NO_DIRTY;
+        DP_DirtyLast[page] = DP_NO_DIRTY;
+        DP_WinPage = DP_NO_WINDOW; /* The window is finished */
+      } else {
+        DP_DirtyFirst[page] = (UB)(first + chunk);
+        DP_WinNext = DP_DirtyFirst[page];
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Clears the frame buffer and forgets the region texts, 
+ * so the next flush redraws the whole screen (e.g. after the init screen).
+ * The screen itself keeps its content until the next flush.
+ */
+void InvalidateDisplay() {
+  if (nullptr == DP_Display) {
+    return;
+  }
+
+  DP_Display->clearDisplay();
+  DP_WinPage = DP_NO_WINDOW; /* The window may be changed by display() */
+  for (UB i = 0; i < DP_RegionCount; i++) {
+    DP_Regions[i].text[0] = '\0';
+  }
+  DP_MarkDirty(0, 0, DP_Display->width(), DP_Display->height());
+}
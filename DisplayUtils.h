@@ -0,0 +1,79 @@
+/**
+ * @file DisplayUtils.h
+ * @brief Header file for the partial (dirty region) refresh of the SSD1306 OLED.
+ * The screen is split into fixed text regions. A region is re-rendered 
+ * only in the character cells whose text has changed, and only the 
+ * changed page/column windows of the frame buffer are sent over I2C 
+ * (SSD1306 page/column addressing). Nothing is sent when no text changed.
+ * The transfer is split over several FlushDisplay() calls (DISP_FLUSH_CHUNKS 
+ * per call) and gives way to the reserved sensor transactions (BusUtils).
+ * The characters of DISP_GLYPH_SET are pre-rendered at the sizes of the 
+ * page-aligned regions and copied into the frame buffer as whole bytes.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef DISPLAY_UTILS_H
+#define DISPLAY_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Adafruit_SSD1306.h> /* SSD1306 Display driver */
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+#define DISP_REGION_MAX 4 /* Maximal number of the text regions */
+#define DISP_TEXT_LEN 12 /* Maximal text length of one region (incl. terminator) */
+#define DISP_I2C_CHUNK 31 /* Data bytes per I2C transmission (+1 control byte = Wire buffer) */
+#define DISP_INVALID_REGION 0xFF /* Region ID returned when the table is full */
+#define DISP_GLYPH_SET "0123456789.-+ /Ch%\x18\x19" /* Cached characters (0x18/0x19 = arrows) */
+#define DISP_GLYPH_CACHE_SIZE 2560 /* Glyph cache memory [B], 6 * size^2 bytes per character */
+#define DISP_FLUSH_CHUNKS 2 /* Max. data chunks per FlushDisplay() call (~0.8 ms per chunk at 400 kHz) */
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Connects the partial refresh to an initialized display.
+ * @param display The display (display.begin() already called).
+ * @param address The display I2C address.
+ */
+void Init_Display(Adafruit_SSD1306* display, UB address);
+
+/**
+ * @brief Registers a text region (one line of the classic 6x8 font).
+ * @param x Left edge [px].
+ * @param y Top edge [px] (multiple of 8 = page-aligned, uses the glyph cache).
+ * @param textSize Text scale (1 = 6x8 px per character).
+ * @param maxChars Region width [characters] (max. DISP_TEXT_LEN - 1).
+ * @return UB Region ID, or DISP_INVALID_REGION when the table is full.
+ */
+UB AddDisplayRegion(int16_t x, int16_t y, UB textSize, UB maxChars);
+
+/**
+ * @brief Sets the text of a region, only the changed character cells are rendered.
+ * @param id The region ID.
+ * @param text The new text (longer text is cut at the region width).
+ */
+void SetDisplayRegionText(UB id, const char* text);
+
+/**
+ * @brief Sends the next part of the changed frame buffer to the display (nothing if unchanged).
+ * @return bool True if the whole change is sent, false if a part is left for the next call.
+ */
+bool FlushDisplay(void);
+
+/**
+ * @brief Clears the frame buffer and forgets the region texts, 
+ * so the next flush redraws the whole screen (e.g. after the init screen).
+ */
+void InvalidateDisplay(void);
+
+#endif // DISPLAY_UTILS_H
@@ -0,0 +1,197 @@
+/**
+ * @file FilterUtils.h
+ * @brief Generic, instantiable Exponential Smoothing filter.
+ * The filter is a template parameterized on the value type, the smoothing 
+ * factor (as a compile-time fraction) and the number of channels. The state 
+ * of all channels is kept in one contiguous block and all channels can be 
+ * updated in one call. Supported value types:
+ * - float: value and state in single precision.
+ * - SL: value in hundredths (e.g. 2406 = 24.06), state in Q16.16 hundredths.
+ * Besides the compile-time factor, a step can use a runtime factor (Alpha 
+ * type of the traits), e.g. for a variable sample period.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef FILTER_UTILS_H
+#define FILTER_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Number of the fractional bits of the fixed-point filter state.
+ */
+#define FILTER_FX_SHIFT 16
+
+/**
+ * @brief 1.0 and 0.5 in the fixed-point format.
+ */
+#define FILTER_FX_ONE (1L << FILTER_FX_SHIFT)
+#define FILTER_FX_HALF (1L << (FILTER_FX_SHIFT - 1))
+
+// --------------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Value type specific part of the filter (state type and one smoothing step).
+ * @tparam T The value type (float or SL).
+ */
+template <typename T>
+struct ExpSmoothTraits;
+
+/**
+ * @brief Floating-point filter: state = value.
+ * Formula: filtered = (ALPHA * raw) + ((1 - ALPHA) * filtered)
+ */
+template <>
+struct ExpSmoothTraits<float> {
+  typedef float State;
+  typedef float Alpha; /* Runtime smoothing factor */
+
+  static State FromValue(float value) { return value; }
+  static float ToValue(State state) { return state; }
+  static Alpha AlphaFromFloat(float alpha) { return alpha; }
+
+  template <UW ALPHA_NUM, UW ALPHA_DEN>
+  static float Step(State* state, float raw) {
+    /* Both factors are folded to single precision constants by the compiler */
+    *state = (((float)ALPHA_NUM / ALPHA_DEN) * raw) + ((1.0f - ((float)ALPHA_NUM / ALPHA_DEN)) * *state);
+    return *state;
+  }
+
+  static float StepAlpha(State* state, float raw, Alpha alpha) {
+    *state = (alpha * raw) + ((1.0f - alpha) * *state);
+    return *state;
+  }
+};
+
+/**
+ * @brief Fixed-point filter: value in hundredths, state in Q16.16 hundredths.
+ * Formula: state += ALPHA * (raw - state), ALPHA as a compile-time Q0.16 constant.
+ * The product needs 64 bits (difference up to 2^30 times ALPHA).
+ */
+template <>
+struct ExpSmoothTraits<SL> {
+  typedef SL State;
+  typedef SL Alpha; /* Runtime smoothing factor in Q0.16 */
+
+  static State FromValue(SL value) { return value * FILTER_FX_ONE; }
+  static SL ToValue(State state) { return (state + FILTER_FX_HALF) >> FILTER_FX_SHIFT; }
+  static Alpha AlphaFromFloat(float alpha) {
+    /* Rounded, at least 1 LSB (a zero factor would freeze the filter) */
+    SL alphaFx = (SL)((alpha * FILTER_FX_ONE) + 0.5f);
+    return (alphaFx < 1) ? 1 : ((alphaFx > FILTER_FX_ONE) ? FILTER_FX_ONE : alphaFx);
+  }
+
+  template <UW ALPHA_NUM, UW ALPHA_DEN>
+  static SL Step(State* state, SL raw) {
+    /* ALPHA in Q0.16, e.g. 3/100 -> 1966 */
+    const SL alphaFx = (SL)((((long long)ALPHA_NUM << FILTER_FX_SHIFT) + (ALPHA_DEN / 2)) / ALPHA_DEN);
+    *state += (SL)(((long long)alphaFx * (FromValue(raw) - *state)) >> FILTER_FX_SHIFT);
+    return ToValue(*state);
+  }
+
+  static SL StepAlpha(State* state, SL raw, Alpha alphaFx) {
+    *state += (SL)(((long long)alphaFx * (FromValue(raw) - *state)) >> FILTER_FX_SHIFT);
+    return ToValue(*state);
+  }
+};
+
+/**
+ * @brief Multi-channel Exponential Smoothing filter.
+ * The type is an aggregate, so an instance can be initialized at compile time:
+ * ExpSmoothFilter<float, 3, 100, 2> filter = {{20.0f, 55.0f}};
+ * @tparam T The value type (float or SL).
+ * @tparam ALPHA_NUM Numerator of the smoothing factor.
+ * @tparam ALPHA_DEN Denominator of the smoothing factor (ALPHA = ALPHA_NUM / ALPHA_DEN).
+ * @tparam CHANNELS Number of the filtered signals.
+ */
+template <typename T, UW ALPHA_NUM, UW ALPHA_DEN, UB CHANNELS>
+struct ExpSmoothFilter {
+  static_assert((ALPHA_NUM > 0) && (ALPHA_NUM <= ALPHA_DEN), "ALPHA must be in (0, 1>");
+  static_assert(CHANNELS > 0, "At least one channel is required");
+
+  typedef T Value;
+  typedef ExpSmoothTraits<T> Traits;
+  typedef typename Traits::State State;
+  typedef typename Traits::Alpha Alpha;
+
+  /**
+   * @brief Filter state of all channels (one contiguous block, use the methods only).
+   */
+  State state[CHANNELS];
+
+  /**
+   * @brief Sets the filter state of one channel to the initial value.
+   * @param ch The channel index.
+   * @param value The initial (starting) value.
+   */
+  void Init(UB ch, T value) {
+    state[ch] = Traits::FromValue(value);
+  }
+
+  /**
+   * @brief Performs one smoothing step on one channel.
+   * @param ch The channel index.
+   * @param raw The current raw value.
+   * @return T The new filtered value.
+   */
+  T Run(UB ch, T raw) {
+    return Traits::template Step<ALPHA_NUM, ALPHA_DEN>(&state[ch], raw);
+  }
+
+  /**
+   * @brief Performs one smoothing step on all channels.
+   * @param raw The current raw values (CHANNELS items).
+   * @param filtered Output for the new filtered values (CHANNELS items).
+   */
+  void RunAll(const T* raw, T* filtered) {
+    for (UB ch = 0; ch < CHANNELS; ch++) {
+      filtered[ch] = Traits::template Step<ALPHA_NUM, ALPHA_DEN>(&state[ch], raw[ch]);
+    }
+  }
+
+  /**
+   * @brief Performs one smoothing step on one channel with a runtime smoothing factor.
+   * @param ch The channel index.
+   * @param raw The current raw value.
+   * @param alpha The smoothing factor (see Traits::AlphaFromFloat()).
+   * @return T The new filtered value.
+   */
+  T RunAlpha(UB ch, T raw, Alpha alpha) {
+    return Traits::StepAlpha(&state[ch], raw, alpha);
+  }
+
+  /**
+   * @brief Performs one smoothing step on all channels with a runtime smoothing factor.
+   * @param raw The current raw values (CHANNELS items).
+   * @param filtered Output for the new filtered values (CHANNELS items).
+   * @param alpha The smoothing factor (see Traits::AlphaFromFloat()).
+   */
+  void RunAllAlpha(const T* raw, T* filtered, Alpha alpha) {
+    for (UB ch = 0; ch < CHANNELS; ch++) {
+      filtered[ch] = Traits::StepAlpha(&state[ch], raw[ch], alpha);
+    }
+  }
+
+  /**
+   * @brief Gets the current filtered value of one channel.
+   * @param ch The channel index.
+   * @return T The filtered value.
+   */
+  T Get(UB ch) const {
+    return Traits::ToValue(state[ch]);
+  }
+};
+
+#endif // FILTER_UTILS_H
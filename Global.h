@@ -13,6 +13,16 @@
 /* Helper macro to define local-scope (private) variables/functions */
 #define PRIVATE static
 
+/* WiFi */
+#define WIFI_ACTIVE 1 /* Enable/Disable WIFI conection */
+/* WiFi disabled (0) - For debug purpose over serial cable connection. 
+ * WiFi enabled  (1) - Establish WiFi connection and MQTT connection.
+ */
+
+/* Sensors */
+#define SENSOR_COUNT 1 /* Number of the SHT31 boards on the I2C bus (1 or 2: addresses 0x45, 0x44) */
+#define SENSOR_PRIMARY 0 /* Channel shown on the display and kept in the history, log and RTC state */
+
 /**
  * @brief Typedef for unsigned 8-bit integer (unsigned char). Range 0 to 255.
  */
@@ -23,4 +33,19 @@ typedef unsigned char UB;
  */
 typedef signed char SB;
 
+/**
+ * @brief Typedef for unsigned 16-bit integer (unsigned short). Range 0 to 65535.
+ */
+typedef unsigned short UW;
+
+/**
+ * @brief Typedef for signed 16-bit integer (signed short). Range -32768 to 32767.
+ */
+typedef signed short SW;
+
+/**
+ * @brief Typedef for signed 32-bit integer (signed long on ESP8266).
+ */
+typedef signed long SL;
+
 #endif /* GLOBAL_H */
\ No newline at end of file
@@ -0,0 +1,208 @@
+/**
+ * @file HistoryUtils.cpp
+ * @brief Implementation file for the multi-resolution measurement history.
+ * This file provides the definitions (logic) for the functions 
+ * declared in HistoryUtils.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h> /* millis() */
+#include "Global.h"
+#include "HistoryUtils.h"
+
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+#define HU_RAM_SIZE ((HIST_MINUTE_COUNT + HIST_HOUR_COUNT + HIST_DAY_COUNT) * sizeof(HistRecord))
+static_assert(HU_RAM_SIZE <= HIST_MAX_RAM, "History rings exceed HIST_MAX_RAM");
+
+// --------------------------------------------------------------------------
+// PRIVATE TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Running aggregate of the currently open interval of one tier.
+ * Sums (not means) are merged into the next tier, so the means stay exact.
+ */
+typedef struct {
+  unsigned long start; /* millis() of the first sample [ms] */
+  unsigned long count; /* Number of raw samples */
+  SL tmprSum;          /* Sum of the temperatures [0.01 C] */
+  SL humiSum;          /* Sum of the humidities [0.01 %] */
+  SW tmprMin;
+  SW tmprMax;
+  UW humiMin;
+  UW humiMax;
+} HU_Accum;
+
+/**
+ * @brief One history tier (ring buffer + open interval).
+ */
+typedef struct {
+  HistRecord* ring;     /* Record storage */
+  UW size;              /* Ring length [records] */
+  UW head;              /* Index of the next write (oldest record when full) */
+  UW count;             /* Number of valid records */
+  unsigned long period; /* Interval length [ms] */
+  HU_Accum acc;         /* Open interval */
+} HU_Tier;
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Record storage of the tiers.
+ */
+PRIVATE HistRecord HU_MinuteRing[HIST_MINUTE_COUNT];
+PRIVATE HistRecord HU_HourRing[HIST_HOUR_COUNT];
+PRIVATE HistRecord HU_DayRing[HIST_DAY_COUNT];
+
+/**
+ * @brief History tiers, the finest resolution first.
+ */
+PRIVATE HU_Tier HU_Tiers[HIST_TIER_COUNT] = {
+  {HU_MinuteRing, HIST_MINUTE_COUNT, 0, 0, HIST_MINUTE_TIME, {0, 0, 0, 0, 0, 0, 0, 0}},
+  {HU_HourRing, HIST_HOUR_COUNT, 0, 0, HIST_HOUR_TIME, {0, 0, 0, 0, 0, 0, 0, 0}},
+  {HU_DayRing, HIST_DAY_COUNT, 0, 0, HIST_DAY_TIME, {0, 0, 0, 0, 0, 0, 0, 0}}
+};
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Merges an aggregate (one sample or a closed interval) into an open interval.
+ * @param acc The open interval.
+ * @param src The merged aggregate.
+ */
+PRIVATE void HU_Merge(HU_Accum* acc, const HU_Accum* src) {
+  if (0 == acc->count) {
+    *acc = *src;
+    return;
+  }
+  acc->count += src->count;
+  acc->tmprSum += src->tmprSum;
+  acc->humiSum += src->humiSum;
+  if (src->tmprMin < acc->tmprMin) acc->tmprMin = src->tmprMin;
+  if (src->tmprMax > acc->tmprMax) acc->tmprMax = src->tmprMax;
+  if (src->humiMin < acc->humiMin) acc->humiMin = src->humiMin;
+  if (src->humiMax > acc->humiMax) acc->humiMax = src->humiMax;
+}
+
+/**
+ * @brief Rounded division of a sum by the sample count.
+ * @param sum The sum.
+ * @param count The sample count (> 0).
+ * @return SL The mean value.
+ */
+PRIVATE SL HU_Mean(SL sum, unsigned long count) {
+  SL half = (SL)(count / 2);
+  return (sum >= 0) ? ((sum + half) / (SL)count) : ((sum - half) / (SL)count);
+}
+
+/**
+ * @brief Closes the open interval of a tier: stores its record and merges it into the next tier.
+ * @param tier The tier index.
+ */
+PRIVATE void HU_Close(UB tier) {
+  HU_Tier* t = &HU_Tiers[tier];
+  HistRecord* rec = &t->ring[t->head];
+
+  rec->time = (uint32_t)t->acc.start;
+  rec->tmprMin = t->acc.tmprMin;
+  rec->tmprMax = t->acc.tmprMax;
+  rec->tmprMean = (SW)HU_Mean(t->acc.tmprSum, t->acc.count);
+  rec->humiMin = t->acc.humiMin;
+  rec->humiMax = t->acc.humiMax;
+  rec->humiMean = (UW)HU_Mean(t->acc.humiSum, t->acc.count);
+
+  t->head = (t->head + 1) % t->size;
+  if (t->count < t->size) {
+    t->count++;
+  }
+
+  if ((tier + 1) < HIST_TIER_COUNT) {
+    HU_Merge(&HU_Tiers[tier + 1].acc, &t->acc);
+  }
+  t->acc.count = 0;
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Clears all history tiers.
+ */
+void Init_History() {
+  for (UB i = 0; i < HIST_TIER_COUNT; i++) {
+    HU_Tiers[i].head = 0;
+    HU_Tiers[i].count = 0;
+    HU_Tiers[i].acc.count = 0;
+  }
+}
+
+/**
+ * @brief Adds one raw sample to the history (closes the finished minute/hour/day).
+ * An interval is closed by the first sample after its end, the finer tier 
+ * first, so a closed minute is already part of the hour checked next.
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+void AddSampleToHistory(SL tmpr, SL hum) {
+  unsigned long now = millis();
+  HU_Accum sample;
+
+  for (UB i = 0; i < HIST_TIER_COUNT; i++) {
+    HU_Tier* t = &HU_Tiers[i];
+    if ((t->acc.count > 0) && ((now - t->acc.start) >= t->period)) {
+      HU_Close(i);
+    }
+  }
+
+  sample.start = now;
+  sample.count = 1;
+  sample.tmprSum = tmpr;
+  sample.humiSum = hum;
+  sample.tmprMin = (SW)sample.tmprSum;
+  sample.tmprMax = (SW)sample.tmprSum;
+  sample.humiMin = (UW)sample.humiSum;
+  sample.humiMax = (UW)sample.humiSum;
+  HU_Merge(&HU_Tiers[HIST_TIER_MINUTE].acc, &sample);
+}
+
+/**
+ * @brief Gets the number of the stored records of one tier.
+ * @param tier The history tier (HIST_TIER_xxx).
+ * @return UW The number of records.
+ */
+UW GetHistoryCount(UB tier) {
+  if (tier >= HIST_TIER_COUNT) {
+    return 0;
+  }
+  return HU_Tiers[tier].count;
+}
+
+/**
+ * @brief Gets one stored record of a tier.
+ * @param tier The history tier (HIST_TIER_xxx).
+ * @param idx The record index (0 = newest).
+ * @param record Output record.
+ * @return bool True if the record exists.
+ */
+bool GetHistoryRecord(UB tier, UW idx, HistRecord* record) {
+  if ((tier >= HIST_TIER_COUNT) || (idx >= HU_Tiers[tier].count)) {
+    return false;
+  }
+  const HU_Tier* t = &HU_Tiers[tier];
+  *record = t->ring[(t->head + t->size - 1 - idx) % t->size];
+  return true;
+}
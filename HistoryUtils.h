@@ -0,0 +1,100 @@
+/**
+ * @file HistoryUtils.h
+ * @brief Header file for the multi-resolution measurement history.
+ * Raw samples are rolled up into per-minute min/max/mean records, the 
+ * minutes into per-hour and the hours into per-day records. Each tier is 
+ * a fixed-size ring buffer (sized at compile time), the oldest record is 
+ * overwritten when the ring is full.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef HISTORY_UTILS_H
+#define HISTORY_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <stdint.h>
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief History tiers (index for GetHistoryCount() / GetHistoryRecord()).
+ */
+#define HIST_TIER_MINUTE 0
+#define HIST_TIER_HOUR 1
+#define HIST_TIER_DAY 2
+#define HIST_TIER_COUNT 3
+
+/* Tier resolution [ms] */
+#define HIST_MINUTE_TIME 60000UL
+#define HIST_HOUR_TIME 3600000UL
+#define HIST_DAY_TIME 86400000UL
+
+/* Tier length [records] */
+#define HIST_MINUTE_COUNT 180 /* 3 hours */
+#define HIST_HOUR_COUNT 168 /* 7 days */
+#define HIST_DAY_COUNT 31 /* 31 days (age must stay below the millis() wrap, 49 days) */
+
+/**
+ * @brief Maximal RAM footprint of the history rings [bytes].
+ */
+#define HIST_MAX_RAM 8192
+
+// --------------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief One history record (aggregate of one minute / hour / day).
+ * Values in hundredths (e.g. 2406 = 24.06 C).
+ */
+typedef struct {
+  uint32_t time;      /* millis() of the first sample in the interval [ms] (fixed width) */
+  SW tmprMin;         /* Minimal temperature [0.01 C] */
+  SW tmprMax;         /* Maximal temperature [0.01 C] */
+  SW tmprMean;        /* Mean temperature [0.01 C] */
+  UW humiMin;         /* Minimal humidity [0.01 %] */
+  UW humiMax;         /* Maximal humidity [0.01 %] */
+  UW humiMean;        /* Mean humidity [0.01 %] */
+} HistRecord;
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Clears all history tiers.
+ */
+void Init_History(void);
+
+/**
+ * @brief Adds one raw sample to the history (closes the finished minute/hour/day).
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+void AddSampleToHistory(SL tmpr, SL hum);
+
+/**
+ * @brief Gets the number of the stored records of one tier.
+ * @param tier The history tier (HIST_TIER_xxx).
+ * @return UW The number of records.
+ */
+UW GetHistoryCount(UB tier);
+
+/**
+ * @brief Gets one stored record of a tier.
+ * @param tier The history tier (HIST_TIER_xxx).
+ * @param idx The record index (0 = newest).
+ * @param record Output record.
+ * @return bool True if the record exists.
+ */
+bool GetHistoryRecord(UB tier, UW idx, HistRecord* record);
+
+#endif // HISTORY_UTILS_H
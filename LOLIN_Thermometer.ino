@@ -46,78 +46,163 @@ MQTT:
 // --------------------------------------------------------------------------
 
 #include <Wire.h> /* TWI/I2C library for Arduino & Wiring */
-#include "Adafruit_SHT31.h" /* SHT31 - Adafruit SHT31 Library */
 #include <Adafruit_GFX.h> /* Basic graphic lib */
 #include <Adafruit_SSD1306.h> /* SSD1306 Display driver */
-#include <ESP8266WiFi.h> /* WiFi lib for ESP8266 */
-#include <PubSubClient.h> /* MQTT client */
-#include <ArduinoJson.h> /* JSON lib */
+#include <LittleFS.h> /* Flash file system (config, log) */
 
 #include "Global.h"
 #include "DataUtils.h" /* Measured data processing */
+#include "Scheduler.h" /* Cooperative task scheduler */
+#include "SensorUtils.h" /* SHT31 sensor sampling */
+#include "MqttUtils.h" /* MQTT connection and publishing */
+#include "WifiUtils.h" /* WiFi connection */
+#include "RtcUtils.h" /* RTC memory records */
+#include "HistoryUtils.h" /* Minute/hour/day history */
+#include "LogUtils.h" /* Persisted log of the unsent samples */
+#include "DisplayUtils.h" /* Partial OLED refresh */
+#include "BusUtils.h" /* Shared I2C bus (fast-mode, sensor priority) */
+#include "ProfileUtils.h" /* Hot path timing statistics */
+#include "ConfigUtils.h" /* Runtime configuration */
+#include "OtaUtils.h" /* Firmware update over HTTP */
+#include "ConsoleUtils.h" /* Buffered serial log */
 
 // --------------------------------------------------------------------------
 // CONSTANTS / CONFIGURATION
 // --------------------------------------------------------------------------
 
-/* Serial connection configuration: */
+/* Serial connection configuration (log level: CONSOLE_LEVEL in ConsoleUtils.h): */
 #define SERIAL_BAUD_RATE 115200 /* Serial connection speed [bits/sec] */
 #define SERIAL_INIT_DELAY 100 /* Initial connection delay [ms] */
+#define TREND_DUMP_VALUES 20 /* Trend buffer values per debug line */
 
-/* SHT31 Sensor configuration: */
-#define SHT30_ADDRESS 0x45 /* Therm/Hygrometer I2C address */
+/* SHT31 Sensor configuration (number of the sensors: SENSOR_COUNT in Global.h): */
+#define SHT30_ADDRESS 0x45 /* Therm/Hygrometer I2C address (channel 0, SENSOR_PRIMARY) */
+#define SHT30_ADDRESS_2 0x44 /* Address of the second board (channel 1, ADDR pin high) */
+#define SENSOR_INIT_RETRIES 3 /* Init attempts of a sensor at boot */
+#define SENSOR_STATUS_PERIOD 60000 /* Period of the sensor status register check [ms] */
 
 /* Display SSD1306 configuration: */
 #define SCREEN_WIDTH 128 /* OLED width in pixels */
 #define SCREEN_HEIGHT 64 /* OLED height in pixels */
 #define OLED_RESET -1 /* Reset pin (set to '-1' as it is not connected) */
 #define SCREEN_ADDRESS 0x3C /* Display I2C address */
-#define INIT_SCREEN_TIME 2000 /* Initial info displayed duration [ms] */
+#define INIT_SCREEN_TIME 2000 /* Initial info displayed duration (non-blocking) [ms] */
+#define DISPLAY_RESTART_DELAY 5000 /* Delay before the restart when the display init failed [ms] */
+
+/* Display text regions (registered in this order in setup()) */
+#define REGION_TMPR 0 /* Line 1: Filtered temperature (large font) */
+#define REGION_RAW 1 /* Line 2: Raw temperature and humidity */
+#define REGION_TREND 2 /* Line 3: Trend indicator and rate */
 
 /* Main loop configuration */
-#define LOOP_TIME 6000 /* Loop time in milliseconds */
+#define LOOP_TIME 6000 /* Measurement cycle time in milliseconds */
 #define BLINK_TIME 100 /* Blink duration for the on-board LED [ms] */ 
 #define BLINK_ACTIVE 0 /* 1-Enable / 0-Disable blink activity */ 
 
-/* MQTT broker (Mosquitto) on Raspberry Pi */
-#define MQTT_SERVER "192.168.241.111" /* IP address Raspberry Pi (Mosquitto Broker) */
-#define MQTT_PORT 1883
-#define MQTT_CLIENT_ID "LolinThermometer_01" /* Unique ID for this senzor */
-#define MQTT_TOPIC_TEMP "home/thermometer/temperature"
-#define MQTT_TOPIC_HUM "home/thermometer/humidity"
-#define MQTT_TOPIC_STATUS "home/thermometer/status"
-
-/* WiFi */
-#define WIFI_ACTIVE 1 /* Enable/Disable WIFI conection */
-/* WiFi disabled (0) - For debug purpose over serial cable connection. 
- * WiFi enabled  (1) - Establish WiFi connection and MQTT connection.
- */
-#if (WIFI_ACTIVE == 1)
-#define WIFI_SSID "YOUR_WIFI_SSID" 
-#define WIFI_PASSWORD "YOUR_WIFI_PASSWORD"
-#endif
+/* Scheduler task periods */
+#define SAMPLE_PERIOD LOOP_TIME /* Sensor sampling period [ms] */
+#define DISPLAY_PERIOD LOOP_TIME /* OLED display refresh period [ms] */
+#define PUBLISH_PERIOD LOOP_TIME /* MQTT publish period [ms] */
+#define BLINK_PERIOD LOOP_TIME /* On-board LED blink period [ms] */
+
+/* Adaptive sampling: the sample period follows the signal activity (ADAPT_MIN_TIME..ADAPT_MAX_TIME),
+ * the trend is sampled at the fixed TREND_SAMPLE_TIME. Continuous mode only (ignored with DEEP_SLEEP_ACTIVE). */
+#define SAMPLE_ADAPTIVE_ACTIVE 0 /* 1-Enable / 0-Disable adaptive sample period */
+
+/* Battery (deep-sleep) mode configuration: wake, sample, publish, sleep.
+ * Requires the D0 (GPIO16) to RST connection for the wake-up. */
+#define DEEP_SLEEP_ACTIVE 0 /* 1-Enable / 0-Disable duty-cycled deep-sleep mode */
+#define DEEP_SLEEP_TIME 60000 /* Sleep time between two measurements [ms] */
+#define DEEP_SLEEP_NET_TIMEOUT 5000 /* Max. time awake waiting for WiFi/MQTT [ms] */
+
+/* Number of the tasks registered in setup(), keep in line with the AddSchedulerTask() calls:
+ * sample start/fetch, filter, display, display flush, console + trend + blink 
+ * + network, publish, drain, status, history + profile + backfill + OTA */
+#define TASK_COUNT (6 + (SAMPLE_ADAPTIVE_ACTIVE && !DEEP_SLEEP_ACTIVE) + BLINK_ACTIVE + \
+                    (WIFI_ACTIVE * (5 + PROF_ACTIVE + LOG_ACTIVE + OTA_ACTIVE)))
+static_assert(TASK_COUNT <= SCHED_MAX_TASKS, "Scheduler table too small, raise SCHED_MAX_TASKS");
 
 // --------------------------------------------------------------------------
 // MAIN DATA
 // --------------------------------------------------------------------------
 
-Adafruit_SHT31 sht30 = Adafruit_SHT31(); /* Instance for the SHT31 sensor */
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET); /* Instance for the SSD1306 display */
+/* Instance for the SSD1306 display, the bus stays at I2C_CLOCK also after display() (driver default is 100 kHz) */
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET, I2C_CLOCK, I2C_CLOCK);
+
+/* Compile-time configuration, used until a config is received over MQTT (then stored in flash) */
+const Config configDefaults = {
+  ALPHA_NUM, ALPHA_DEN, SAMPLE_PERIOD, DISPLAY_PERIOD, PUBLISH_PERIOD, TREND_COUNT,
+  MQTT_DEADBAND_TMPR, MQTT_DEADBAND_HUM, MQTT_HEARTBEAT_TIME
+};
+
+/* Sensor registry: I2C address of each channel (the first SENSOR_COUNT entries are used) */
+const UB sensorAddress[SENSOR_MAX_COUNT] = {SHT30_ADDRESS, SHT30_ADDRESS_2};
+
+/* Latest measured values of each sensor channel shared between the scheduler tasks */
+SL t_raw[SENSOR_COUNT]; /* Rounded raw temperature [0.01 C] */
+SL h_raw[SENSOR_COUNT]; /* Rounded raw humidity [0.01 %] */
+SL t_filt[SENSOR_COUNT]; /* Filtered temperature [0.01 C] */
+SL h_filt[SENSOR_COUNT]; /* Filtered humidity [0.01 %] */
+bool sampleValid[SENSOR_COUNT]; /* Last measurement of the channel was valid */
+bool sensorStarted[SENSOR_COUNT]; /* Filter and trend of the channel started from a measured value */
+UB sampleChannel = 0; /* Channel of the running measurement (round-robin within one cycle) */
+UB h_round = (UB)DEFAULT_HUMI; /* Rounded humidity value of the primary channel (UB type) */
+bool newSample = false; /* New raw samples (one cycle over all channels) are waiting for the filter task */
+UB blinkTaskId = SCHED_INVALID_TASK; /* Scheduler ID of the blink task */
+UB sampleTaskId = SCHED_INVALID_TASK; /* Scheduler ID of the sample start task */
+UB displayTaskId = SCHED_INVALID_TASK; /* Scheduler ID of the display task */
+UB publishTaskId = SCHED_INVALID_TASK; /* Scheduler ID of the publish task */
+bool displayPending = false; /* Display refreshed, the changes are being sent by Task_DisplayFlush() */
+#if (SAMPLE_ADAPTIVE_ACTIVE == 1) && (DEEP_SLEEP_ACTIVE == 0)
+unsigned long samplePeriod = SAMPLE_PERIOD; /* Current adaptive sample period [ms] */
+#endif /* SAMPLE_ADAPTIVE_ACTIVE */
 
-#if (WIFI_ACTIVE == 1)
-WiFiClient espClient; /* WiFi Client */
-PubSubClient client(espClient); /* MQTT client is using WiFI client */
-#endif
 // --------------------------------------------------------------------------
 // FUNCTION PROTOTYPES
 // --------------------------------------------------------------------------
 
-void PrintToDisplay(float t_filt, float t_raw, UB h);
-void PrintToSerial(float t, float t_filt, UB h);
+bool StartSensor(UB ch, SL* t, SL* h);
+void Task_SampleStart();
+void StartChannelMeasurement(UB ch);
+void Task_SampleFetch();
+void Task_Filter();
+void Task_Display();
+void Task_DisplayFlush();
+void Task_Blink();
+void Task_Console();
+void PrintToDisplay(SL t_filt, SL t_raw, UB h);
+const char* GetDisplayTmprFormat(SL t);
+void PrintToSerial(SL t, SL t_filt, SL h);
+void SaveDataState();
+bool RestoreDataState();
+bool RestoreOutlierState();
+void ApplyConfig();
+#if (SAMPLE_ADAPTIVE_ACTIVE == 1) && (DEEP_SLEEP_ACTIVE == 0)
+void Task_Trend();
+void UpdateSamplePeriod();
+#endif
+#if (DEEP_SLEEP_ACTIVE == 1)
+void RunDutyCycle();
+#if (WIFI_ACTIVE == 1)
+bool WaitsForLogClock();
+#endif
+#endif
 #if (WIFI_ACTIVE == 1)
-void WifiSetup();
-void ReconnectMqtt();
-void PublishData(float tmpr, UB hum);
+void Task_Network();
+void Task_Publish();
+void Task_Drain();
+void Task_Status();
+void Task_History();
+#if (PROF_ACTIVE == 1)
+void Task_Profile();
+#endif
+#endif
+#if (WIFI_ACTIVE == 1) && (LOG_ACTIVE == 1)
+void Task_Backfill();
+#endif
+#if (WIFI_ACTIVE == 1) && (OTA_ACTIVE == 1)
+void Task_Ota();
+void RebootAfterOta();
 #endif
 
 // --------------------------------------------------------------------------
@@ -130,41 +215,94 @@ void setup() {
   pinMode(LED_BUILTIN, OUTPUT);
   
   /* Initialize serial communication */
-  Serial.begin(SERIAL_BAUD_RATE);
+  Init_Console(SERIAL_BAUD_RATE);
   delay(SERIAL_INIT_DELAY); /* Delay to stabilize the connection */
-  Serial.println("\n");
-  Serial.println("Serial communication initialized.");
+  CONSOLE_INFO("\n\nSerial communication initialized.");
   
-  /* Initialize SHT31 sensor and check connection */
-  if (!sht30.begin(SHT30_ADDRESS)) {  
-    Serial.println("ERROR: SHT31 sensor not found!");
-    for(;;); // Hard program termination
+  SL t_init = QuantizeFx<DU_DECIMALS>(DEFAULT_TEMP);
+  SL h_init = QuantizeFx<DU_DECIMALS>(DEFAULT_HUMI);
+
+  /* Initialize SHT31 sensor, check connection and data validity (CRC, NaN, range).
+   * A failing sensor does not stop the program: the measurement keeps trying it 
+   * and soft-resets it after SENSOR_RESET_ERRORS failures. */
+  RestoreOutlierState(); /* Before the first sample passes the outlier stage */
+  bool primaryOk = StartSensor(SENSOR_PRIMARY, &t_init, &h_init);
+  if (primaryOk) {
+    CONSOLE_INFO("OK: SHT31 sensor connected, data OK.");
+  } else {
+    CONSOLE_ERROR("SHT31 sensor not found or data invalid, measurement continues without it!");
+    t_init = QuantizeFx<DU_DECIMALS>(DEFAULT_TEMP);
+    h_init = QuantizeFx<DU_DECIMALS>(DEFAULT_HUMI);
   }
-  Serial.println("OK: SHT31 sensor connected and initialized.");
-  
-  float t_init = sht30.readTemperature();
-  float h_init = sht30.readHumidity();
 
-  /* Check for data validity (e.g., is not NaN) */
-  if (isnan(t_init) || isnan(h_init)) {
-    Serial.println("ERROR: Error reading from sensor SHT31!");
-    for(;;); // Hard program termination
+  t_raw[SENSOR_PRIMARY] = t_init;
+  h_raw[SENSOR_PRIMARY] = h_init;
+  sampleValid[SENSOR_PRIMARY] = primaryOk;
+  sensorStarted[SENSOR_PRIMARY] = primaryOk;
+
+  /* Other channels: a missing sensor is reported, the measurement continues without it */
+  for (UB ch = 0; ch < SENSOR_COUNT; ch++) {
+    if (SENSOR_PRIMARY == ch) {
+      continue;
+    }
+    sensorStarted[ch] = StartSensor(ch, &t_raw[ch], &h_raw[ch]);
+    if (!sensorStarted[ch]) {
+      CONSOLE_WARN("SHT31 sensor 0x%02X (channel %u) not found!", sensorAddress[ch], ch);
+      t_raw[ch] = QuantizeFx<DU_DECIMALS>(DEFAULT_TEMP);
+      h_raw[ch] = QuantizeFx<DU_DECIMALS>(DEFAULT_HUMI);
+    }
+    t_filt[ch] = t_raw[ch];
+    h_filt[ch] = h_raw[ch];
+    sampleValid[ch] = false; /* Not part of the first filter pass (already the initial value) */
+    Init_SensorSmooth(ch, t_raw[ch], h_raw[ch]);
+    Init_SensorTrend(ch, t_raw[ch]);
   }
-  Serial.println("OK: SHT31 sensor data OK.");
 
-  t_init = RoundToDecimals(t_init, 2);
-  Init_TmprSmooth(t_init);
-  Init_TmprTrendBuffer(t_init);
-    
-  h_init = RoundToDecimals(h_init, 2);
-  Init_HumiSmooth(h_init);
+  /* Time base of the trend rate (one trend sample per measurement, continuous mode: ApplyConfig()) */
+#if (DEEP_SLEEP_ACTIVE == 1)
+  SetTrendSampleTime(DEEP_SLEEP_TIME);
+#elif (SAMPLE_ADAPTIVE_ACTIVE == 1)
+  SetTrendSampleTime(TREND_SAMPLE_TIME); /* Fixed trend period, independent of the sample period */
+#endif /* DEEP_SLEEP_ACTIVE */
+  Init_History();
+
+  /* The file system is mounted once here, the config and the log only check the result */
+  bool fsMounted = LittleFS.begin();
+  if (!fsMounted) {
+    CONSOLE_ERROR("LittleFS mount failed, default config used, log disabled!");
+  }
+
+  /* Stored configuration, applied before the data state is restored (smoothing factor, trend window) */
+  if (Init_Config(&configDefaults, fsMounted)) {
+    CONSOLE_INFO("OK: Config loaded from flash.");
+  }
+  ApplyConfig();
+
+  if (RestoreDataState()) {
+    /* Smoothing and trend survived the sleep/reset, continue with the new sample */
+    CONSOLE_INFO("OK: Data state restored from RTC memory.");
+    sensorStarted[SENSOR_PRIMARY] = true;
+    newSample = true;
+    Task_Filter();
+  } else {
+    Init_TmprSmooth(t_init);
+    Init_TmprTrendBuffer(t_init);
+    Init_HumiSmooth(h_init);
+    t_filt[SENSOR_PRIMARY] = t_init;
+    h_filt[SENSOR_PRIMARY] = h_init;
+  }
 
   /* Initialize the OLED display */
   if(!display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
-    Serial.println("ERROR: OLED display not found!");
-    while (1) delay(1);
-    /* TODO (Optionaly: program termination is not necessary, measurement can still runs) */
+    /* No frame buffer, the display can not be skipped: restart instead of hanging, 
+     * the smoothing continues from the RTC state after the restart */
+    CONSOLE_ERROR("OLED display init failed, restart!");
+    SaveDataState();
+    FlushConsole();
+    delay(DISPLAY_RESTART_DELAY);
+    ESP.restart();
   }
+  Init_Bus(); /* Fast-mode I2C for the sensor and the display */
   
   /* Display preparation (buffer clearing & init text)*/
   display.clearDisplay();
@@ -177,104 +315,495 @@ void setup() {
   display.println();
   display.println("OLED: OK");
   display.println();
-  display.println("I2C sensor: OK");
+  display.println(primaryOk ? "I2C sensor: OK" : "I2C sensor: ERROR");
+#if (WIFI_ACTIVE == 1)
+  display.println("WiFi: connecting...");
+#else
   display.println();
+#endif /* WIFI_ACTIVE */
   display.setTextSize(2);
   display.print("iT: ");
-  display.println(t_init);
+  display.println(FromFx<DU_DECIMALS>(t_init));
   display.display(); /* Update the display buffer */ 
 
-  delay(INIT_SCREEN_TIME);
-  display.clearDisplay();
+  /* Partial refresh of the measured values (init screen stays until the first refresh),
+   * the regions are page-aligned (y = 0, 32, 48), so their characters come from the glyph cache */
+  Init_Display(&display, SCREEN_ADDRESS);
+  AddDisplayRegion(0, 0, 4, 5);   /* REGION_TMPR:  "24.06" / "-10.6" (5 characters fill the width) */
+  AddDisplayRegion(0, 32, 2, 10); /* REGION_RAW:   "24.06C 65%" */
+  AddDisplayRegion(0, 48, 2, 10); /* REGION_TREND: "^ +0.4/h" */
+  InvalidateDisplay();
 
-#if (WIFI_ACTIVE == 1)
-  display.setTextSize(1);
-  display.setCursor(0, 0); /* Set cursor to the top-left corner */
-  display.println("Setup WIFI...");
-  display.display(); /* Update the display buffer */ 
+#if (LOG_ACTIVE == 1)
+  Init_Log(fsMounted);
+#endif /* LOG_ACTIVE */
 
-  WifiSetup();
-  
-  display.println("Setup MQTT...");
-  display.display(); /* Update the display buffer */ 
+#if (DEEP_SLEEP_ACTIVE == 1)
+  RunDutyCycle(); /* Never returns, the board is reset by the wake-up */
+#endif /* DEEP_SLEEP_ACTIVE */
 
-  client.setServer(MQTT_SERVER, MQTT_PORT);
-  
-  display.println("Setup OK");
-  display.display(); /* Update the display buffer */ 
-  
-  delay(INIT_SCREEN_TIME);
-  display.clearDisplay();
+#if (WIFI_ACTIVE == 1)
+  /* Network comes up in the background, setup() does not wait for it */
+  Init_Wifi();
+  Init_Mqtt();
 #endif /* WIFI_ACTIVE */
+
+  /* Register scheduler tasks (executed in this order within one pass), periods from the config */
+  const Config* config = GetConfig();
+#if (WIFI_ACTIVE == 1)
+  AddSchedulerTask(Task_Network, SCHED_EVERY_PASS, 0);
+#endif /* WIFI_ACTIVE */
+  sampleTaskId = AddSchedulerTask(Task_SampleStart, config->samplePeriod, 0);
+  AddSchedulerTask(Task_SampleFetch, SCHED_EVERY_PASS, 0);
+  AddSchedulerTask(Task_Filter, SCHED_EVERY_PASS, 0);
+#if (SAMPLE_ADAPTIVE_ACTIVE == 1) && (DEEP_SLEEP_ACTIVE == 0)
+  AddSchedulerTask(Task_Trend, TREND_SAMPLE_TIME, TREND_SAMPLE_TIME);
+#endif /* SAMPLE_ADAPTIVE_ACTIVE */
+  /* Initial info stays on the display until the first refresh */
+  displayTaskId = AddSchedulerTask(Task_Display, config->displayPeriod, INIT_SCREEN_TIME);
+  AddSchedulerTask(Task_DisplayFlush, SCHED_EVERY_PASS, 0);
+#if (WIFI_ACTIVE == 1)
+  publishTaskId = AddSchedulerTask(Task_Publish, config->publishPeriod, 0);
+  AddSchedulerTask(Task_Drain, MQTT_QUEUE_DRAIN_PERIOD, 0);
+  AddSchedulerTask(Task_Status, MQTT_STATUS_PERIOD, MQTT_STATUS_PERIOD);
+  AddSchedulerTask(Task_History, MQTT_HIST_PERIOD, 0);
+#if (PROF_ACTIVE == 1)
+  AddSchedulerTask(Task_Profile, PROF_REPORT_PERIOD, PROF_REPORT_PERIOD);
+#endif /* PROF_ACTIVE */
+#endif /* WIFI_ACTIVE */
+#if (WIFI_ACTIVE == 1) && (LOG_ACTIVE == 1)
+  AddSchedulerTask(Task_Backfill, LOG_BACKFILL_PERIOD, 0);
+#endif /* LOG_ACTIVE */
+#if (WIFI_ACTIVE == 1) && (OTA_ACTIVE == 1)
+  AddSchedulerTask(Task_Ota, OTA_PERIOD, 0);
+#endif /* OTA_ACTIVE */
+  if (BLINK_ACTIVE) {
+    blinkTaskId = AddSchedulerTask(Task_Blink, BLINK_PERIOD, 0);
+  }
+  /* Last task: the output of the pass goes to the UART FIFO */
+  AddSchedulerTask(Task_Console, SCHED_EVERY_PASS, 0);
 }
 
 void loop() {
+  /* Run all due tasks, loop() returns immediately (no delay) */
+  Run_Scheduler();
+}
 
-  float t_filt = 0; // Filtered temperature value
-  float h_filt = 0;
-  UB h_round = 0; // Rounded humidity value (UB type)
+// --------------------------------------------------------------------------
+// SCHEDULER TASKS
+// --------------------------------------------------------------------------
 
-#if (WIFI_ACTIVE == 1)
-  /* Check MQTT connection */
-  if (!client.connected()) {
-    /* Try to reconnect */
-    ReconnectMqtt();
+/**
+ * @brief Initializes one sensor and takes its first reading (valid and in range), 
+ * a failing sensor is tried again, SENSOR_INIT_RETRIES times (soft-reset by 
+ * SensorUtils after SENSOR_RESET_ERRORS failures, as during the measurement).
+ * @param ch The sensor channel.
+ * @param t Output for the temperature [0.01 C].
+ * @param h Output for the humidity [0.01 %].
+ * @return bool True if the sensor delivered a valid reading.
+ */
+bool StartSensor(UB ch, SL* t, SL* h) {
+  float tf;
+  float hf;
+
+  for (UB i = 0; i < SENSOR_INIT_RETRIES; i++) {
+    if (Init_Sensor(ch, sensorAddress[ch]) && ReadSensor(ch, &tf, &hf)) {
+      /* Quantized once, the sample path works in hundredths up to the output */
+      *t = QuantizeFx<DU_DECIMALS>(tf);
+      *h = QuantizeFx<DU_DECIMALS>(hf);
+      if (0 == (RejectSensorOutliers(ch, t, h) & DU_FAULT_RANGE)) {
+        return true;
+      }
+    }
+    delay(SHT31_RESET_TIME); /* The failures are counted by SensorUtils, a soft reset may be running */
   }
-  /* MQTT client processing of incoming/outgoing packets */
-  client.loop();
-#endif /* WIFI_ACTIVE */
-  
-  if (BLINK_ACTIVE) {
-    digitalWrite(LED_BUILTIN, LOW);
-    delay(BLINK_TIME);
-    digitalWrite(LED_BUILTIN, HIGH);
-  } 
-  else {
-    /* blink time must be stil used due to main loop duration */
-    delay(BLINK_TIME);
-  }
-    
-  float t = sht30.readTemperature();
-  float h = sht30.readHumidity();
-  
-  /* Check for data validity (e.g., is not NaN) */
-  if (isnan(t) || isnan(h)) {
-    Serial.println("ERROR: Error reading from sensor SHT31!");
-    return; /* Skip the rest of the current loop iteration */
+  return false;
+}
+
+/**
+ * @brief Starts the measurement cycle over all sensor channels, the results are 
+ * collected by Task_SampleFetch(). Other tasks keep running during the sensor 
+ * conversion time. Every SENSOR_STATUS_PERIOD the status registers are checked 
+ * first (no measurement is pending between two cycles).
+ */
+void Task_SampleStart() {
+  static unsigned long lastStatusCheck = 0;
+  unsigned long now = millis();
+
+  if ((now - lastStatusCheck) >= SENSOR_STATUS_PERIOD) {
+    lastStatusCheck = now;
+    for (UB ch = 0; ch < SENSOR_COUNT; ch++) {
+      UW status;
+      if (CheckSensorStatus(ch, &status) && (status & (SHT31_STATUS_RESET | SHT31_STATUS_HEATER))) {
+        CONSOLE_WARN("SHT31 sensor (channel %u) status 0x%04X", ch, status);
+      }
+    }
+  }
+  StartChannelMeasurement(0);
+}
+
+/**
+ * @brief Starts the measurement of the next responding channel (round-robin, one 
+ * transaction on the shared bus at a time). After the last channel the cycle 
+ * is handed over to Task_Filter() (if any channel delivered a valid sample).
+ * @param ch The first channel to try.
+ */
+void StartChannelMeasurement(UB ch) {
+  for (; ch < SENSOR_COUNT; ch++) {
+    sampleChannel = ch;
+    if (StartSensorMeasurement(ch)) {
+      return; /* Collected by Task_SampleFetch() */
+    }
+    sampleValid[ch] = false;
+    CONSOLE_ERROR("Error starting measurement on sensor SHT31 (channel %u)!", ch);
   }
 
-  t = RoundToDecimals(t, 2);
-  AddTmprToTrendBuffer(t);
-  t_filt = Run_TmprSmooth(t);
-  t_filt = RoundToDecimals(t_filt, 2);
+  for (ch = 0; ch < SENSOR_COUNT; ch++) {
+    newSample = newSample || sampleValid[ch];
+  }
+}
+
+/**
+ * @brief Collects the raw temperature and humidity when the conversion is finished
+ * and starts the next channel. The new samples are processed by Task_Filter().
+ */
+void Task_SampleFetch() {
+  float t;
+  float h;
+  UB ch = sampleChannel;
+
+  if (!IsSensorMeasurementReady()) {
+    return; /* No measurement pending or conversion still running */
+  }
   
-  h = RoundToDecimals(h, 2);
-  h_filt = Run_HumiSmooth(h);
-  h_filt = RoundToDecimals(h_filt, 2);
+  /* Check for data validity (CRC) */
+  uint32_t span = StartProfileSpan();
+  bool valid = FetchSensorMeasurement(&t, &h);
+  StopProfileSpan(PROF_SPAN_SENSOR, span);
+  if (valid) {
+    /* Quantized once, the sample path works in hundredths up to the output */
+    SL ts = QuantizeFx<DU_DECIMALS>(t);
+    SL hs = QuantizeFx<DU_DECIMALS>(h);
+    /* Outlier stage ahead of the smoothing: out of range rejected, spikes replaced by the median */
+    UB faults = RejectSensorOutliers(ch, &ts, &hs);
+    if (faults & DU_FAULT_RANGE) {
+      valid = false;
+      CONSOLE_WARN("SHT31 sensor (channel %u) value out of range!", ch);
+    } else {
+      if (faults != DU_FAULT_NONE) {
+        CONSOLE_WARN("SHT31 sensor (channel %u) outlier replaced (0x%02X)", ch, faults);
+      }
+      t_raw[ch] = ts;
+      h_raw[ch] = hs;
+    }
+  } else {
+    CONSOLE_ERROR("Error reading from sensor SHT31 (channel %u)!", ch); /* Skip the sample of this channel */
+  }
+  sampleValid[ch] = valid;
 
-  /* Cast humidity to integer (UB type) */
-  h_round = (UB)round(h);
+  StartChannelMeasurement(ch + 1);
+}
+
+/**
+ * @brief Processes a new raw sample (trend buffer and smoothing).
+ * Runs on every scheduler pass, but does work only when a new sample is available.
+ */
+void Task_Filter() {
+  if (!newSample) {
+    return;
+  }
+  newSample = false;
+
+  uint32_t span = StartProfileSpan();
+  for (UB ch = 0; ch < SENSOR_COUNT; ch++) {
+    if (!sampleValid[ch]) {
+      continue; /* Filter and trend of the channel keep the previous state */
+    }
+    if (!sensorStarted[ch]) {
+      /* First valid sample of a sensor missing at boot: start from it, not from DEFAULT_TEMP */
+      Init_SensorSmooth(ch, t_raw[ch], h_raw[ch]);
+      Init_SensorTrend(ch, t_raw[ch]);
+      sensorStarted[ch] = true;
+    }
+#if (SAMPLE_ADAPTIVE_ACTIVE == 0) || (DEEP_SLEEP_ACTIVE == 1)
+    AddSensorTmprToTrend(ch, t_raw[ch]); /* Adaptive sampling: Task_Trend() */
+#endif /* SAMPLE_ADAPTIVE_ACTIVE */
+    /* Both values in one pass over the filter state of the channel */
+    Run_SensorSmooth(ch, t_raw[ch], h_raw[ch], &t_filt[ch], &h_filt[ch]);
+  }
+
+  bool primaryValid = sampleValid[SENSOR_PRIMARY];
+  if (primaryValid) {
+    AddSampleToHistory(t_raw[SENSOR_PRIMARY], h_raw[SENSOR_PRIMARY]);
+
+    /* Cast humidity to integer (UB type) */
+    h_round = (UB)((h_raw[SENSOR_PRIMARY] + 50) / 100);
   
-  /* Clamp humidity to 100% */
-  if (h_round > 100) {
-    h_round = 100;
+    /* Clamp humidity to 100% */
+    if (h_round > 100) {
+      h_round = 100;
+    }
+#if (SAMPLE_ADAPTIVE_ACTIVE == 1) && (DEEP_SLEEP_ACTIVE == 0)
+    UpdateSamplePeriod();
+#endif /* SAMPLE_ADAPTIVE_ACTIVE */
+  }
+  StopProfileSpan(PROF_SPAN_FILTER, span);
+
+  span = StartProfileSpan();
+  for (UB ch = 0; ch < SENSOR_COUNT; ch++) {
+    if (SENSOR_PRIMARY == ch) {
+      if (primaryValid) {
+        PrintToSerial(t_raw[ch], t_filt[ch], h_filt[ch]);
+      }
+    } else if (sampleValid[ch]) {
+      CONSOLE_INFO("Ch%u T_raw: %.2f C, T_filt: %.2f C | H_filt: %.2f %%", ch, 
+                   FromFx<DU_DECIMALS>(t_raw[ch]), FromFx<DU_DECIMALS>(t_filt[ch]), FromFx<DU_DECIMALS>(h_filt[ch]));
+    }
+  }
+  StopProfileSpan(PROF_SPAN_SERIAL, span);
+}
+
+#if (SAMPLE_ADAPTIVE_ACTIVE == 1) && (DEEP_SLEEP_ACTIVE == 0)
+/**
+ * @brief Adds the latest raw temperature to the trend buffer (fixed TREND_SAMPLE_TIME).
+ * So the trend rate keeps its time base at any sample period: a long period 
+ * repeats the held sample, a short one is decimated.
+ */
+void Task_Trend() {
+  for (UB ch = 0; ch < SENSOR_COUNT; ch++) {
+    AddSensorTmprToTrend(ch, t_raw[ch]);
   }
+}
+#endif /* SAMPLE_ADAPTIVE_ACTIVE */
+
+/**
+ * @brief Refreshes the OLED display with the latest processed values.
+ */
+void Task_Display() {
+  uint32_t span = StartProfileSpan();
+  PrintToDisplay(t_filt[SENSOR_PRIMARY], t_raw[SENSOR_PRIMARY], h_round);
+  StopProfileSpan(PROF_SPAN_DISPLAY, span);
+  displayPending = true;
+}
 
-  /* Print measured signals */  
-  PrintToSerial(t, t_filt, h_filt);
-  PrintToDisplay(t_filt, t, h_round);
+/**
+ * @brief Sends the changed display areas in small chunks (on every scheduler pass).
+ * The sensor transactions have priority, so the sampling is not delayed by the refresh.
+ * Only the calls after a refresh are timed (the idle passes return immediately).
+ */
+void Task_DisplayFlush() {
+  if (!displayPending) {
+    return;
+  }
+
+  uint32_t span = StartProfileSpan();
+  displayPending = !FlushDisplay();
+  StopProfileSpan(PROF_SPAN_FLUSH, span);
+}
+
+/**
+ * @brief Moves the buffered log output to the UART (only as much as the TX FIFO takes).
+ */
+void Task_Console() {
+  Run_Console();
+}
+
+/**
+ * @brief Blinks the on-board LED (LED is active LOW).
+ * The task switches the LED on and plans its own next run after BLINK_TIME
+ * to switch it off again, so no delay() is needed.
+ */
+void Task_Blink() {
+  static bool ledOn = false;
+
+  ledOn = !ledOn;
+  digitalWrite(LED_BUILTIN, ledOn ? LOW : HIGH);
+  SetSchedulerTaskPeriod(blinkTaskId, ledOn ? BLINK_TIME : (BLINK_PERIOD - BLINK_TIME));
+}
 
 #if (WIFI_ACTIVE == 1)
+/**
+ * @brief Services the WiFi and MQTT connection on every scheduler pass.
+ * Both state machines make at most one attempt per pass. The latest values 
+ * are published right after the (re)connection, not one period later.
+ */
+void Task_Network() {
+  static bool wasConnected = false;
+
+  Run_Wifi();
+  Run_Mqtt();
+
+  if (IsConfigChanged()) {
+    /* New config received over MQTT (already stored in flash) */
+    ApplyConfig();
+    CONSOLE_INFO("Config applied.");
+  }
+
+  bool connected = IsMqttConnected();
+  if (connected && !wasConnected) {
+#if (MQTT_BATCH_ACTIVE == 1)
+    PublishBatch(); /* Send the batch if it became due while disconnected */
+#else
+    Task_Publish();
+#endif /* MQTT_BATCH_ACTIVE */
+  }
+  wasConnected = connected;
+}
+
+/**
+ * @brief Sends the latest filtered values to the MQTT broker.
+ * In the batch mode the values are buffered and sent as one message 
+ * per MQTT_BATCH_SIZE samples (or MQTT_BATCH_TIME).
+ */
+void Task_Publish() {
+  if (!sensorStarted[SENSOR_PRIMARY]) {
+    return; /* No measured value yet (sensor missing since the boot) */
+  }
+#if (MQTT_QUEUE_ACTIVE == 1)
+  if (!IsMqttConnected()) {
+    /* Keep the sample in the RAM queue (spilled to the log when full), Task_Drain() sends it after the reconnect */
+    QueueSample(t_filt[SENSOR_PRIMARY], h_filt[SENSOR_PRIMARY]);
+    return;
+  }
+#elif (LOG_ACTIVE == 1)
+  if (!IsMqttConnected()) {
+    /* Keep the sample in the log, Task_Backfill() sends it after the reconnect */
+    AppendToLog(t_filt[SENSOR_PRIMARY], h_filt[SENSOR_PRIMARY]);
+    return;
+  }
+#endif /* MQTT_QUEUE_ACTIVE */
+
+  uint32_t span = StartProfileSpan();
+#if (MQTT_BATCH_ACTIVE == 1)
+  AddSampleToBatch(t_filt[SENSOR_PRIMARY], h_filt[SENSOR_PRIMARY]);
+  PublishBatch();
+#else
   /* Send MQTT data to MQTT broker */
-  if (client.connected()) {
+  if (IsMqttConnected()) {
     /* Publish only in case of available client connection */
-    PublishData(t_filt, h_filt);
+    PublishData(t_filt[SENSOR_PRIMARY], h_filt[SENSOR_PRIMARY]);
   }
+#endif /* MQTT_BATCH_ACTIVE */
+#if (SENSOR_COUNT > 1)
+  /* All channels of the last cycle in one message */
+  PublishSensors(t_filt, h_filt, sampleValid);
+#endif /* SENSOR_COUNT */
+  StopProfileSpan(PROF_SPAN_PUBLISH, span);
+}
+
+/**
+ * @brief Replays the offline queue after the reconnect (one chunk per MQTT_QUEUE_DRAIN_PERIOD).
+ * The chunks are spread over the scheduler passes, so sampling and display keep running.
+ */
+void Task_Drain() {
+  if (IsMqttConnected() && (GetQueueCount() > 0)) {
+    DrainQueue();
+  }
+}
+
+/**
+ * @brief Publishes the device status (queue/log statistics) periodically.
+ */
+void Task_Status() {
+  if (IsMqttConnected()) {
+    PublishStatus();
+  }
+}
+
+/**
+ * @brief Answers the history query received on MQTT_TOPIC_HISTORY_REQ (one chunk per MQTT_HIST_PERIOD).
+ */
+void Task_History() {
+  if (IsMqttConnected() && IsHistoryQueryPending()) {
+    ServeHistoryQuery();
+  }
+}
+
+#if (PROF_ACTIVE == 1)
+/**
+ * @brief Publishes the timing statistics of the last PROF_REPORT_PERIOD.
+ * While disconnected the window keeps growing until the next report.
+ */
+void Task_Profile() {
+  if (IsMqttConnected()) {
+    PublishProfile();
+  }
+}
+#endif /* PROF_ACTIVE */
 #endif /* WIFI_ACTIVE */
-  
-  delay(LOOP_TIME - BLINK_TIME);
-  /* Adjust main loop delay time for blink duration */
+
+#if (WIFI_ACTIVE == 1) && (LOG_ACTIVE == 1)
+/**
+ * @brief Sends the logged samples to the broker (one chunk per LOG_BACKFILL_PERIOD).
+ * The backfill waits for the SNTP time, so the records of the current clock 
+ * epoch get their Unix time. The read position is moved only after the chunk 
+ * was published.
+ */
+void Task_Backfill() {
+  LogRecord records[LOG_BACKFILL_CHUNK];
+
+  if (!IsMqttConnected() || !IsLogClockSynced()) {
+    return;
+  }
+
+  UB count = ReadLog(records, LOG_BACKFILL_CHUNK);
+  if ((count > 0) && PublishLogRecords(records, count)) {
+    CommitLogRead(count);
+  }
 }
+#endif /* LOG_ACTIVE */
+
+#if (WIFI_ACTIVE == 1) && (OTA_ACTIVE == 1)
+/**
+ * @brief Runs the firmware download (one chunk per OTA_PERIOD) and reboots into the new image.
+ * The progress is published on every state change and every OTA_REPORT_STEP bytes.
+ */
+void Task_Ota() {
+  static UB lastState = OTA_STATE_IDLE;
+  static uint32_t lastReport = 0;
+
+  if (!IsOtaRunning() && (GetOtaState() == lastState)) {
+    return;
+  }
+
+  uint32_t span = StartProfileSpan();
+  Run_Ota();
+  StopProfileSpan(PROF_SPAN_OTA, span);
+
+  UB state = GetOtaState();
+  uint32_t progress = GetOtaProgress();
+  if ((state != lastState) || ((progress - lastReport) >= OTA_REPORT_STEP)) {
+    lastState = state;
+    lastReport = progress;
+    PublishOtaStatus();
+  }
+  if (OTA_STATE_DONE == state) {
+    RebootAfterOta();
+  }
+}
+
+/**
+ * @brief Reboots into the new firmware. The DataUtils state is saved to the RTC 
+ * memory first (the records are behind the area used by the OTA bootloader), 
+ * so the smoothing and the trend continue after the boot instead of 
+ * reconverging from DEFAULT_TEMP. The samples of the offline queue are moved 
+ * to the log, the log batch and the serial log are flushed.
+ */
+void RebootAfterOta() {
+  CONSOLE_INFO("OTA: rebooting into the new firmware...");
+  ClearOtaRequest(); /* A retained request would start the update again after the boot */
+  DisconnectMqtt(); /* Sends the pending messages (done status, cleared request) */
+  SaveDataState();
+#if (LOG_ACTIVE == 1)
+#if (MQTT_QUEUE_ACTIVE == 1)
+  SpillQueue(); /* Not replayed yet, keep the samples over the reboot */
+#endif /* MQTT_QUEUE_ACTIVE */
+  FlushLog();
+#endif /* LOG_ACTIVE */
+  FlushConsole();
+  ESP.restart();
+}
+#endif /* OTA_ACTIVE */
 
 // --------------------------------------------------------------------------
 // MAIN HELPER FUNCTIONS
@@ -282,174 +811,258 @@ void loop() {
 
 /**
  * @brief Prints current temperature and humidity values to the OLED display.
- * @param t_filt The filtered temperature value.
- * @param t_raw The raw temperature value.
+ * @param t_filt The filtered temperature value [0.01 C].
+ * @param t_raw The raw temperature value [0.01 C].
  * @param h The rounded humidity value (0-100%).
  */
-void PrintToDisplay(float t_filt, float t_raw, UB h){
-  /* Prepare display for output */  
-  display.clearDisplay();
-  
+void PrintToDisplay(SL t_filt, SL t_raw, UB h){
+  char text[DISP_TEXT_LEN];
+
   /* Line 1: Filtered Temperature (Large font) */
-  display.setCursor(0, 0);
-  display.setTextSize(4);
-  display.print(t_filt);
+  snprintf(text, sizeof(text), GetDisplayTmprFormat(t_filt), FromFx<DU_DECIMALS>(t_filt));
+  SetDisplayRegionText(REGION_TMPR, text);
   
   /* Line 2: Raw Temperature and Humidity (Smaller font) */
-  display.setCursor(0, 35);
-  display.setTextSize(2);
-  display.print(t_raw);
-  display.print("C ");
-  display.print(h);
-  display.println("%");
+  int len = snprintf(text, sizeof(text), GetDisplayTmprFormat(t_raw), FromFx<DU_DECIMALS>(t_raw));
+  snprintf(&text[len], sizeof(text) - len, "C %u%%", h);
+  SetDisplayRegionText(REGION_RAW, text);
   
-  /* Line 3: Temperature Trend Indicator */
+  /* Line 3: Temperature Trend Indicator and rate of change */
   SB trend = GetTemperatureTrend();
+  char indicator;
   if (1 == trend) {
-    display.write(24); // Arrow UP symbol (24)
+    indicator = 24; // Arrow UP symbol (24)
   } else if (-1 == trend) {
-    display.write(25); // Arrow DOWN symbol (25)
+    indicator = 25; // Arrow DOWN symbol (25)
   } else {
-    display.print("-"); /* Stable (no significant change) */
+    indicator = '-'; /* Stable (no significant change) */
   }
+  snprintf(text, sizeof(text), "%c %+.1f/h", indicator, GetTmprTrendRate());
+  SetDisplayRegionText(REGION_TREND, text);
 
-  display.print(" a:");
-  display.print(ALPHA);
+  /* Only the changed areas are sent by Task_DisplayFlush() (nothing if the texts did not change) */
+}
 
-  display.display();  // Update the OLED display
+/**
+ * @brief Gets the display format of a temperature: 5 characters (width of the 
+ * large font region), two decimals, one decimal from -10 C and from 100 C.
+ * @param t The temperature [0.01 C].
+ * @return const char* The printf format.
+ */
+const char* GetDisplayTmprFormat(SL t) {
+  return ((t <= -1000) || (t >= 10000)) ? "%.1f" : "%.2f";
 }
 
+#if (SAMPLE_ADAPTIVE_ACTIVE == 1) && (DEEP_SLEEP_ACTIVE == 0)
 /**
- * @brief Prints current temperature and humidity values to the Serial Monitor.
- * @param t The raw temperature value.
- * @param t_filt The filtered temperature value.
- * @param h The rounded humidity value (0-100%).
+ * @brief Adapts the sample period to the signal activity (trend rate, raw - filtered).
+ * The scheduler keeps the phase of the last sample, so the next sample comes 
+ * exactly one new period later and the converted smoothing factor matches it. 
+ * Publishing follows a long period, but is not faster than the configured publish period.
+ * Not applied before the tasks are registered (sample restored in setup()).
  */
-void PrintToSerial(float t, float t_filt, float h){
-  /* Temperature info */
-  Serial.print("T_raw: ");
-  Serial.print(t, 2); /* number of decimal places */
-  Serial.print(" C, T_filt: ");
-  Serial.print(t_filt, 2);
-  Serial.print(" C");
-
-  /* Humidity info */
-  Serial.print(" | H_filt: ");
-  Serial.print(h, 2);
-  Serial.print(" %");
-
-  /* DEBUG: Checking Trend-buffer values */
-  // Serial.print(" Buffer: ");
-  // const float* buffer = GetTmprTrendBuffer();
-  // for (UB i = 0; i < TREND_COUNT; i++) {
-  //   Serial.print(buffer[i]);
-  //   Serial.print(" ");
-  // }
-
-  Serial.println();
+void UpdateSamplePeriod() {
+  if (sampleTaskId == SCHED_INVALID_TASK) {
+    return;
+  }
+
+  unsigned long period = GetAdaptiveSampleTime(samplePeriod, t_raw[SENSOR_PRIMARY] - t_filt[SENSOR_PRIMARY]);
+  if (period == samplePeriod) {
+    return;
+  }
+  samplePeriod = period;
+  SetSmoothSampleTime(period);
+  SetSchedulerTaskPeriod(sampleTaskId, period);
+  unsigned long publishPeriod = GetConfig()->publishPeriod;
+  SetSchedulerTaskPeriod(publishTaskId, (period > publishPeriod) ? period : publishPeriod);
+  CONSOLE_DEBUG("Sample period: %lu ms", period);
 }
+#endif /* SAMPLE_ADAPTIVE_ACTIVE */
+
+/**
+ * @brief Applies the active configuration to the modules (at boot and after a change).
+ * The derived values (converted smoothing factor, deadband in hundredths) are 
+ * computed here once, not per sample. The task periods are set only if the 
+ * tasks are registered (at boot they are registered with the config periods). 
+ * In the deep-sleep mode the periods are given by DEEP_SLEEP_TIME.
+ */
+void ApplyConfig() {
+  const Config* config = GetConfig();
 
+  SetSmoothAlpha((UW)config->alphaNum, (UW)config->alphaDen, ALPHA_SAMPLE_TIME);
+  SetTrendWindow((UW)config->trendWindow);
+#if (DEEP_SLEEP_ACTIVE == 0)
+#if (SAMPLE_ADAPTIVE_ACTIVE == 1)
+  /* Start value, adapted by UpdateSamplePeriod() */
+  samplePeriod = config->samplePeriod;
+  SetSchedulerTaskPeriod(publishTaskId, (samplePeriod > config->publishPeriod) ? samplePeriod : config->publishPeriod);
+#else
+  SetTrendSampleTime(config->samplePeriod);
+  SetSchedulerTaskPeriod(publishTaskId, config->publishPeriod);
+#endif /* SAMPLE_ADAPTIVE_ACTIVE */
+  SetSmoothSampleTime(config->samplePeriod);
+  SetSchedulerTaskPeriod(sampleTaskId, config->samplePeriod);
+  SetSchedulerTaskPeriod(displayTaskId, config->displayPeriod);
+#else
+  SetSmoothSampleTime(DEEP_SLEEP_TIME); /* One smoothing step per wake-up */
+#endif /* DEEP_SLEEP_ACTIVE */
 #if (WIFI_ACTIVE == 1)
-// --------------------------------------------------------------------------
-// WIFI/MQTT FUNCTIONS
-// --------------------------------------------------------------------------
+  SetMqttDeadband((UW)config->deadbandTmpr, (UW)config->deadbandHum, config->heartbeat);
+#endif /* WIFI_ACTIVE */
+}
 
 /**
- * @brief Handles connection to the local WiFi network.
+ * @brief Saves the DataUtils state (filters, trend buffer, outlier windows) to the RTC memory.
  */
-void WifiSetup() {
-  delay(10);
-  Serial.print("Connecting to ");
-  Serial.println(WIFI_SSID);
-
-  IPAddress local_IP(192, 168, 241, 120);
-  IPAddress gateway(192, 168, 241, 1);
-  IPAddress subnet(255, 255, 255, 0);
-  IPAddress primaryDNS(192, 168, 241, 1);
-
-  // Static IP address
-  if (!WiFi.config(local_IP, gateway, subnet, primaryDNS)) {
-    Serial.println("Static IP configuration failed!");
-  }
-
-  WiFi.mode(WIFI_STA); /* LOLIN ESP8266 as client */
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-
-  while (WiFi.status() != WL_CONNECTED) {
-    // TODO add retries
-    delay(500);
-    Serial.print(".");
-    digitalWrite(LED_BUILTIN, LOW);
-    delay(500);
-    digitalWrite(LED_BUILTIN, HIGH);
-  }
-
-  Serial.println("");
-  Serial.println("WiFi connected");
-  Serial.print("Connected to AP: ");
-  Serial.println(WIFI_SSID);
-  Serial.print("IP address: ");
-  Serial.println(WiFi.localIP());
-  Serial.print("Signal: ");
-  Serial.print(WiFi.RSSI());
-  Serial.println(" dBm");
-  Serial.print("Mac: ");
-  Serial.println(WiFi.macAddress());
-  Serial.println("");
+void SaveDataState() {
+  static_assert(sizeof(DU_State) <= RTC_RECORD_MAX_LEN, "DU_State does not fit into RTC record");
+  static_assert(sizeof(DU_OutlierState) <= RTC_RECORD_MAX_LEN, "DU_OutlierState does not fit into RTC record");
+  DU_State state;
+  DU_OutlierState outliers;
+  GetDataUtilsState(&state);
+  WriteRtcRecord(RTC_OFFSET_DATAUTILS, &state, sizeof(state));
+  GetOutlierState(&outliers);
+  WriteRtcRecord(RTC_OFFSET_OUTLIERS, &outliers, sizeof(outliers));
 }
 
 /**
- * @brief Attempts to reconnect to the MQTT broker if the connection is lost.
+ * @brief Restores the DataUtils state from the RTC memory (if valid).
+ * In the continuous mode the record is used only once (e.g. after a reboot), 
+ * so an old snapshot can not be applied by a later unrelated reset.
+ * @return bool True if the state was restored.
  */
-void ReconnectMqtt() {
-  /* Loop until we're reconnected */
-  while (!client.connected()) {
-    Serial.print("Attempting MQTT connection...");
-    
-    /* Attempt to connect */
-    if (client.connect(MQTT_CLIENT_ID, "username_optional", "password_optional")) {
-      Serial.println("connected");
-      /* Publish status on connection */
-      client.publish(MQTT_TOPIC_STATUS, "Device connected and operational.");
-    } else {
-      Serial.print("failed, rc=");
-      Serial.print(client.state());
-      Serial.println(" try again in 5 seconds");
-      // Wait 5 seconds before retrying
-      delay(5000);
+bool RestoreDataState() {
+  DU_State state;
+  bool restored = ReadRtcRecord(RTC_OFFSET_DATAUTILS, &state, sizeof(state)) && SetDataUtilsState(&state);
+
+  if (!DEEP_SLEEP_ACTIVE) {
+    ClearRtcRecord(RTC_OFFSET_DATAUTILS);
+  }
+  if (restored) {
+    t_filt[SENSOR_PRIMARY] = GetTmprFiltered();
+    h_filt[SENSOR_PRIMARY] = GetHumiFiltered();
+  }
+  return restored;
+}
+
+/**
+ * @brief Restores the outlier stage windows from the RTC memory (if valid).
+ * Used the same way as the DataUtils state (once in the continuous mode).
+ * @return bool True if the windows were restored.
+ */
+bool RestoreOutlierState() {
+  DU_OutlierState state;
+  bool restored = ReadRtcRecord(RTC_OFFSET_OUTLIERS, &state, sizeof(state)) && SetOutlierState(&state);
+
+  if (!DEEP_SLEEP_ACTIVE) {
+    ClearRtcRecord(RTC_OFFSET_OUTLIERS);
+  }
+  return restored;
+}
+
+#if (DEEP_SLEEP_ACTIVE == 1)
+/**
+ * @brief One cycle of the battery mode: display, publish, save state and sleep.
+ * The sample was already taken and filtered in setup(). The network is given 
+ * at most DEEP_SLEEP_NET_TIMEOUT, the state is saved even if the publish failed.
+ */
+void RunDutyCycle() {
+#if (SENSOR_COUNT > 1)
+  /* The boot reading of the other channels is the measurement of this wake-up 
+   * (their filter is not kept in the RTC memory, it restarts from this value) */
+  for (UB ch = 0; ch < SENSOR_COUNT; ch++) {
+    if (SENSOR_PRIMARY != ch) {
+      sampleValid[ch] = sensorStarted[ch];
     }
   }
+#endif /* SENSOR_COUNT */
+
+  PrintToDisplay(t_filt[SENSOR_PRIMARY], t_raw[SENSOR_PRIMARY], h_round);
+  while (!FlushDisplay()) {
+    /* No scheduler in this mode, send all chunks now */
+  }
+
+#if (WIFI_ACTIVE == 1)
+  Init_Wifi();
+  Init_Mqtt();
+
+  /* With logged samples also wait for the SNTP time (once per clock epoch, then kept in the RTC memory) */
+  unsigned long start = millis();
+  while ((!IsMqttConnected() || WaitsForLogClock()) && ((millis() - start) < DEEP_SLEEP_NET_TIMEOUT)) {
+    Run_Wifi();
+    Run_Mqtt();
+    Run_Console();
+    delay(1); /* Let the WiFi stack run */
+  }
+
+  if (IsMqttConnected()) {
+    if (sampleValid[SENSOR_PRIMARY]) {
+      /* Nothing new to send if the sensor failed on this wake-up */
+      PublishData(t_filt[SENSOR_PRIMARY], h_filt[SENSOR_PRIMARY]);
+    }
+#if (SENSOR_COUNT > 1)
+    PublishSensors(t_filt, h_filt, sampleValid);
+#endif /* SENSOR_COUNT */
+#if (LOG_ACTIVE == 1)
+    Task_Backfill(); /* One chunk of the logged samples per wake-up */
+#endif /* LOG_ACTIVE */
+    DisconnectMqtt();
+  }
+#if (LOG_ACTIVE == 1)
+  else if (sampleValid[SENSOR_PRIMARY]) {
+    AppendToLog(t_filt[SENSOR_PRIMARY], h_filt[SENSOR_PRIMARY]);
+  }
+#endif /* LOG_ACTIVE */
+#endif /* WIFI_ACTIVE */
+
+#if (LOG_ACTIVE == 1)
+  FlushLog(); /* RAM does not survive the deep sleep */
+  SaveLogClock(DEEP_SLEEP_TIME); /* The clock runs on after the wake-up */
+#endif /* LOG_ACTIVE */
+
+  SaveDataState();
+  CONSOLE_INFO("Deep sleep...");
+  FlushConsole();
+  ESP.deepSleep((uint64_t)DEEP_SLEEP_TIME * 1000ULL, WAKE_RF_DEFAULT);
 }
 
+#if (WIFI_ACTIVE == 1)
 /**
- * @brief Publishes the measured data to the MQTT broker as JSON.
- * @param tmpr Temperature value.
- * @param hum Humidity value.
+ * @brief Checks if the duty cycle should stay awake for the SNTP time (logged samples, epoch offset not known).
+ * @return bool True if the backfill is waiting for the clock.
  */
-void PublishData(float tmpr, float hum) {
-  /* Create JSON doc with dynamic alocation (max. 100 Bytes) */
-  StaticJsonDocument<100> doc;
-  
-  doc["value"] = tmpr;
-  doc["unit"] = "C";
-  
-  /* Serialize JSON na string */
-  char jsonBuffer[100];
-  serializeJson(doc, jsonBuffer);
-  
-  /* Send to MQTT */
-  client.publish(MQTT_TOPIC_TEMP, jsonBuffer);
+bool WaitsForLogClock() {
+#if (LOG_ACTIVE == 1)
+  return (GetLogPendingCount() > 0) && !IsLogClockSynced();
+#else
+  return false;
+#endif /* LOG_ACTIVE */
+}
+#endif /* WIFI_ACTIVE */
+#endif /* DEEP_SLEEP_ACTIVE */
 
-  doc.clear();
+/**
+ * @brief Prints current temperature and humidity values to the Serial Monitor.
+ * @param t The raw temperature value [0.01 C].
+ * @param t_filt The filtered temperature value [0.01 C].
+ * @param h The filtered humidity value [0.01 %].
+ */
+void PrintToSerial(SL t, SL t_filt, SL h){
+  /* One formatted line instead of the separate prints, converted to float only here */
+  CONSOLE_INFO("T_raw: %.2f C, T_filt: %.2f C | H_filt: %.2f %%", 
+               FromFx<DU_DECIMALS>(t), FromFx<DU_DECIMALS>(t_filt), FromFx<DU_DECIMALS>(h));
 
-  doc["value"] = hum;
-  doc["unit"] = "%";
-  serializeJson(doc, jsonBuffer);
-  client.publish(MQTT_TOPIC_HUM, jsonBuffer);
-  
-  Serial.print("MQTT published. T:"); 
-  Serial.print(tmpr);
-  Serial.print(", H:"); 
-  Serial.println(hum);
+#if (CONSOLE_LEVEL >= CONSOLE_LEVEL_DEBUG)
+  /* Trend buffer values [0.01 C] (circular buffer order), TREND_DUMP_VALUES per line */
+  const SW* buffer = GetTmprTrendBuffer();
+  UW window = GetTrendWindow();
+  for (UW i = 0; i < window; i += TREND_DUMP_VALUES) {
+    char line[CONSOLE_LINE_LEN];
+    int len = 0;
+    for (UW k = i; (k < (i + TREND_DUMP_VALUES)) && (k < window); k++) {
+      len += snprintf(&line[len], sizeof(line) - len, " %d", buffer[k]);
+    }
+    CONSOLE_DEBUG("Buffer[%u]:%s", i, line);
+  }
+#endif /* CONSOLE_LEVEL */
 }
-#endif /* WIFI_ACTIVE */
\ No newline at end of file
@@ -0,0 +1,595 @@
+/**
+ * @file LogUtils.cpp
+ * @brief Implementation file for the persisted sample log in LittleFS.
+ * This file provides the definitions (logic) for the functions 
+ * declared in LogUtils.h.
+ * Segment files "/log/NNNNNNNN.bin" are numbered in write order, only the 
+ * newest one is appended. The read cursor (segment, record) is stored in 
+ * "/log/cursor" after every sent chunk, fully sent segments are deleted.
+ * The device clock continues from the RTC memory after a reset or wake-up. 
+ * After a power-on it restarts behind the newest record as a new epoch, 
+ * "/log/epochs" keeps the start and the Unix offset of the last epochs, so 
+ * the records of an epoch get the Unix time as soon as SNTP synchronized 
+ * once in it (also later, after the deep sleep).
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h>
+#include <LittleFS.h> /* Flash file system */
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Global.h"
+#include "LogUtils.h"
+#include "RtcUtils.h" /* Device clock in the RTC memory */
+#include "ConsoleUtils.h" /* Buffered serial log */
+
+#if (LOG_ACTIVE == 1)
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+#define LU_CURSOR_PATH LOG_DIR "/cursor" /* Read cursor file */
+#define LU_EPOCHS_PATH LOG_DIR "/epochs" /* Clock epoch table file */
+#define LU_PATH_LEN 24 /* "/log/NNNNNNNN.bin" + terminator */
+
+static_assert((LOG_PAGE_SIZE % sizeof(LogRecord)) == 0, "LogRecord must fit the flash page");
+static_assert(LOG_BATCH_RECORDS <= 255, "LOG_BATCH_RECORDS exceeds UB");
+
+// --------------------------------------------------------------------------
+// PRIVATE TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Read position in the log (stored in flash as is).
+ */
+typedef struct {
+  uint32_t segment; /* Segment number */
+  uint32_t offset;  /* Record index in the segment */
+} LU_Cursor;
+
+/**
+ * @brief One epoch of the device clock (stored in flash as is).
+ */
+typedef struct {
+  uint32_t start;  /* Device clock at the epoch start [s] */
+  uint32_t offset; /* Unix time - device clock [s], 0 = not known yet */
+} LU_Epoch;
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Log is available (file system mounted).
+ */
+PRIVATE bool LU_Ready = false;
+
+/**
+ * @brief Numbers of the oldest and the newest (write) segment.
+ */
+PRIVATE uint32_t LU_FirstSeg = 0;
+PRIVATE uint32_t LU_LastSeg = 0;
+
+/**
+ * @brief Number of the records in the newest segment.
+ */
+PRIVATE unsigned long LU_LastSegRecords = 0;
+
+/**
+ * @brief Read position (oldest record not sent yet).
+ */
+PRIVATE LU_Cursor LU_ReadPos = {0, 0};
+
+/**
+ * @brief Records waiting for the page write.
+ */
+PRIVATE LogRecord LU_Batch[LOG_BATCH_RECORDS];
+PRIVATE UB LU_BatchCount = 0;
+
+/**
+ * @brief Result of the last ReadLog() call (source and number of the records).
+ */
+PRIVATE bool LU_ReadFromRam = false;
+PRIVATE UB LU_ReadCount = 0;
+
+/**
+ * @brief Number of the records dropped because the log was full.
+ */
+PRIVATE unsigned long LU_Dropped = 0;
+
+/**
+ * @brief Known clock epochs (oldest first, the last one is the current epoch).
+ */
+PRIVATE LU_Epoch LU_Epochs[LOG_EPOCH_COUNT];
+PRIVATE UB LU_EpochCount = 0;
+
+/**
+ * @brief Device clock [s] and the millis() it was updated at.
+ */
+PRIVATE uint32_t LU_Clock = 0;
+PRIVATE unsigned long LU_ClockMillis = 0;
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Builds the file name of a segment.
+ * @param segment The segment number.
+ * @param path Output buffer (LU_PATH_LEN).
+ */
+PRIVATE void LU_SegmentPath(uint32_t segment, char* path) {
+  snprintf(path, LU_PATH_LEN, LOG_DIR "/%08lu.bin", (unsigned long)segment);
+}
+
+/**
+ * @brief Stores the read cursor to flash.
+ */
+PRIVATE void LU_SaveCursor(void) {
+  File f = LittleFS.open(LU_CURSOR_PATH, "w");
+  if (f) {
+    f.write((const uint8_t*)&LU_ReadPos, sizeof(LU_ReadPos));
+    f.close();
+  }
+}
+
+/**
+ * @brief Deletes the oldest segment (fully sent, or dropped when the log is full).
+ */
+PRIVATE void LU_DropFirstSegment(void) {
+  char path[LU_PATH_LEN];
+
+  LU_SegmentPath(LU_FirstSeg, path);
+  LittleFS.remove(path);
+  LU_FirstSeg++;
+  if (LU_ReadPos.segment < LU_FirstSeg) {
+    LU_ReadPos.segment = LU_FirstSeg;
+    LU_ReadPos.offset = 0;
+  }
+}
+
+/**
+ * @brief Starts a new write segment, the oldest one is dropped when LOG_SEGMENT_COUNT is reached.
+ */
+PRIVATE void LU_NewSegment(void) {
+  LU_LastSeg++;
+  LU_LastSegRecords = 0;
+
+  if ((LU_LastSeg - LU_FirstSeg) >= LOG_SEGMENT_COUNT) {
+    if (LU_ReadPos.segment == LU_FirstSeg) {
+      LU_Dropped += LOG_SEGMENT_RECORDS - LU_ReadPos.offset;
+    }
+    LU_DropFirstSegment();
+    LU_SaveCursor();
+  }
+}
+
+/**
+ * @brief Writes the RAM batch to the newest segment (split at the segment end).
+ * On a write error the remaining records are counted as dropped.
+ */
+PRIVATE void LU_WriteBatch(void) {
+  char path[LU_PATH_LEN];
+  UB done = 0;
+
+  while (done < LU_BatchCount) {
+    if (LU_LastSegRecords >= LOG_SEGMENT_RECORDS) {
+      LU_NewSegment();
+    }
+
+    unsigned long space = LOG_SEGMENT_RECORDS - LU_LastSegRecords;
+    UB count = ((unsigned long)(LU_BatchCount - done) < space) ? (LU_BatchCount - done) : (UB)space;
+    size_t written = 0;
+
+    LU_SegmentPath(LU_LastSeg, path);
+    File f = LittleFS.open(path, "a");
+    if (f) {
+      written = f.write((const uint8_t*)&LU_Batch[done], count * sizeof(LogRecord)) / sizeof(LogRecord);
+      f.close();
+    }
+    LU_LastSegRecords += written;
+    if (written < count) {
+      LU_Dropped += LU_BatchCount - done - written;
+      break;
+    }
+    done += count;
+  }
+  LU_BatchCount = 0;
+}
+
+/**
+ * @brief Stores the epoch table to flash (written once per epoch start and SNTP offset).
+ */
+PRIVATE void LU_SaveEpochs(void) {
+  File f = LittleFS.open(LU_EPOCHS_PATH, "w");
+  if (f) {
+    f.write((const uint8_t*)LU_Epochs, LU_EpochCount * sizeof(LU_Epoch));
+    f.close();
+  }
+}
+
+/**
+ * @brief Reads the epoch table from flash (stops at a non-increasing start).
+ */
+PRIVATE void LU_LoadEpochs(void) {
+  LU_EpochCount = 0;
+  File f = LittleFS.open(LU_EPOCHS_PATH, "r");
+  if (!f) {
+    return;
+  }
+  while ((LU_EpochCount < LOG_EPOCH_COUNT) &&
+         (sizeof(LU_Epoch) == f.read((uint8_t*)&LU_Epochs[LU_EpochCount], sizeof(LU_Epoch)))) {
+    if ((LU_EpochCount > 0) && (LU_Epochs[LU_EpochCount].start <= LU_Epochs[LU_EpochCount - 1].start)) {
+      break;
+    }
+    LU_EpochCount++;
+  }
+  f.close();
+}
+
+/**
+ * @brief Starts a new epoch of the device clock, the oldest one is dropped when the table is full.
+ * @param start The device clock at the epoch start [s].
+ * @param offset The Unix offset (0 = not known).
+ */
+PRIVATE void LU_AddEpoch(uint32_t start, uint32_t offset) {
+  if (LU_EpochCount >= LOG_EPOCH_COUNT) {
+    memmove(LU_Epochs, &LU_Epochs[1], (LOG_EPOCH_COUNT - 1) * sizeof(LU_Epoch));
+    LU_EpochCount--;
+  }
+  LU_Epochs[LU_EpochCount].start = start;
+  LU_Epochs[LU_EpochCount].offset = offset;
+  LU_EpochCount++;
+  LU_SaveEpochs();
+}
+
+/**
+ * @brief Moves the device clock by the whole seconds elapsed since the last update.
+ * The remainder stays in LU_ClockMillis, so the clock does not lose time 
+ * (and survives the millis() overflow).
+ */
+PRIVATE void LU_UpdateClock(void) {
+  unsigned long elapsed = (millis() - LU_ClockMillis) / 1000;
+  LU_Clock += (uint32_t)elapsed;
+  LU_ClockMillis += elapsed * 1000;
+}
+
+/**
+ * @brief Gets the device clock of the newest record in flash.
+ * @return uint32_t The device clock [s], 0 if the log is empty.
+ */
+PRIVATE uint32_t LU_NewestRecordClock(void) {
+  char path[LU_PATH_LEN];
+  LogRecord rec;
+
+  for (uint32_t segment = LU_LastSeg; ; segment--) {
+    LU_SegmentPath(segment, path);
+    File f = LittleFS.open(path, "r");
+    if (f) {
+      unsigned long count = f.size() / sizeof(LogRecord);
+      bool ok = (count > 0) && f.seek((count - 1) * sizeof(LogRecord), SeekSet) &&
+                (sizeof(rec) == f.read((uint8_t*)&rec, sizeof(rec)));
+      f.close();
+      if (ok) {
+        return rec.clock;
+      }
+    }
+    if (segment == LU_FirstSeg) {
+      return 0;
+    }
+  }
+}
+
+/**
+ * @brief Restores the device clock: continued from the RTC memory (reset, wake-up), 
+ * or a new epoch behind the newest record (power-on, the RTC memory is lost).
+ */
+PRIVATE void LU_InitClock(void) {
+  uint32_t clock;
+
+  LU_LoadEpochs();
+  LU_ClockMillis = millis();
+  if ((LU_EpochCount > 0) && ReadRtcRecord(RTC_OFFSET_LOGCLOCK, &clock, sizeof(clock)) &&
+      (clock >= LU_Epochs[LU_EpochCount - 1].start)) {
+    LU_Clock = clock;
+    return;
+  }
+
+  uint32_t start = LU_NewestRecordClock();
+  if ((LU_EpochCount > 0) && (LU_Epochs[LU_EpochCount - 1].start > start)) {
+    start = LU_Epochs[LU_EpochCount - 1].start;
+  }
+  LU_Clock = start + 1;
+  LU_AddEpoch(LU_Clock, 0);
+  SaveLogClock(0);
+}
+
+/**
+ * @brief Learns the Unix offset of the current epoch once SNTP is synchronized.
+ * A clock off by more than LOG_CLOCK_TOLERANCE (deep sleep timer drift, time 
+ * lost by a reset without SaveLogClock()) starts a new epoch, so the older 
+ * records keep their offset.
+ */
+PRIVATE void LU_CheckSntp(void) {
+  uint32_t now = (uint32_t)time(nullptr);
+
+  if ((0 == LU_EpochCount) || (now < LOG_TIME_MIN)) {
+    return;
+  }
+  LU_UpdateClock();
+  uint32_t offset = now - LU_Clock;
+  LU_Epoch* epoch = &LU_Epochs[LU_EpochCount - 1];
+
+  if (0 == epoch->offset) {
+    epoch->offset = offset;
+    LU_SaveEpochs();
+  } else if (abs((SL)(offset - epoch->offset)) > LOG_CLOCK_TOLERANCE) {
+    if (LU_Clock > epoch->start) {
+      LU_AddEpoch(LU_Clock, offset);
+    } else {
+      epoch->offset = offset;
+      LU_SaveEpochs();
+    }
+  }
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Restores the log position (segments, read cursor), the file system is mounted by the caller.
+ * The segment numbers are taken from the file names, the record count of 
+ * the newest segment from its size.
+ * @param fsMounted Result of the LittleFS mount (false = log disabled).
+ * @return bool True if the log is available.
+ */
+bool Init_Log(bool fsMounted) {
+  bool found = false;
+  bool partial = false;
+
+  if (!fsMounted) {
+    return false; /* Reported by the caller */
+  }
+  LittleFS.mkdir(LOG_DIR);
+
+  Dir dir = LittleFS.openDir(LOG_DIR);
+  while (dir.next()) {
+    char* end;
+    String name = dir.fileName();
+    unsigned long segment = strtoul(name.c_str(), &end, 10);
+
+    if ((end == name.c_str()) || (0 != strcmp(end, ".bin"))) {
+      continue; /* Not a segment file (cursor) */
+    }
+    if (!found || (segment < LU_FirstSeg)) {
+      LU_FirstSeg = segment;
+    }
+    if (!found || (segment >= LU_LastSeg)) {
+      LU_LastSeg = segment;
+      LU_LastSegRecords = dir.fileSize() / sizeof(LogRecord);
+      partial = (0 != (dir.fileSize() % sizeof(LogRecord)));
+    }
+    found = true;
+  }
+
+  LU_ReadPos.segment = LU_FirstSeg;
+  LU_ReadPos.offset = 0;
+  File f = LittleFS.open(LU_CURSOR_PATH, "r");
+  if (f) {
+    LU_Cursor cursor;
+    if ((sizeof(cursor) == f.read((uint8_t*)&cursor, sizeof(cursor))) &&
+        (cursor.segment >= LU_FirstSeg) && (cursor.segment <= LU_LastSeg)) {
+      LU_ReadPos = cursor;
+    }
+    f.close();
+  }
+  /* Segments sent before a reset, but not deleted yet */
+  while (LU_FirstSeg < LU_ReadPos.segment) {
+    LU_DropFirstSegment();
+  }
+  /* Interrupted write (partial record), do not append behind it */
+  if (partial) {
+    LU_NewSegment();
+  }
+
+  LU_InitClock();
+  LU_Ready = true;
+  return true;
+}
+
+/**
+ * @brief Appends one sample to the log (written to flash per LOG_BATCH_RECORDS).
+ * The sample is stamped with the device clock (converted at the backfill).
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+void AppendToLog(SL tmpr, SL hum) {
+  LogRecord rec;
+
+  rec.clock = GetLogClock(millis());
+  rec.tmpr = (SW)tmpr;
+  rec.humi = (UW)hum;
+  AppendRecordToLog(&rec);
+}
+
+/**
+ * @brief Appends one prepared record to the log (e.g. a sample spilled from the MQTT queue).
+ * @param record The record.
+ */
+void AppendRecordToLog(const LogRecord* record) {
+  if (!LU_Ready) {
+    return;
+  }
+
+  LU_Batch[LU_BatchCount++] = *record;
+  if (LU_BatchCount >= LOG_BATCH_RECORDS) {
+    LU_WriteBatch();
+  }
+  SaveLogClock(0); /* A reset continues at least from the newest record */
+}
+
+/**
+ * @brief Converts a millis() time stamp of a sample to the device clock.
+ * @param sampleTime The millis() of the sample [ms] (max. 24 days old).
+ * @return uint32_t The device clock [s].
+ */
+uint32_t GetLogClock(unsigned long sampleTime) {
+  LU_UpdateClock();
+  return LU_Clock + (uint32_t)((SL)(sampleTime - LU_ClockMillis) / 1000);
+}
+
+/**
+ * @brief Checks if the Unix time of the current clock epoch is known (learns it from SNTP).
+ * @return bool True if the records of the current epoch can be converted to the Unix time.
+ */
+bool IsLogClockSynced() {
+  LU_CheckSntp();
+  return (LU_EpochCount > 0) && (0 != LU_Epochs[LU_EpochCount - 1].offset);
+}
+
+/**
+ * @brief Converts the device clock of a record to the Unix time (at the backfill).
+ * The record belongs to the newest epoch started at or before its clock.
+ * @param record The record.
+ * @return uint32_t The Unix time [s], 0 if the offset of the record's epoch is not known.
+ */
+uint32_t GetLogRecordTime(const LogRecord* record) {
+  for (UB i = LU_EpochCount; i > 0; i--) {
+    const LU_Epoch* epoch = &LU_Epochs[i - 1];
+    if (record->clock >= epoch->start) {
+      return (0 != epoch->offset) ? (record->clock + epoch->offset) : 0;
+    }
+  }
+  return 0; /* Older than the epoch table */
+}
+
+/**
+ * @brief Stores the device clock to the RTC memory (before a reset or the deep sleep).
+ * The RTC memory is not flash, so it is also written after every appended record.
+ * @param sleepTime The time until the next start (deep sleep time) [ms], 0 for a reset.
+ */
+void SaveLogClock(unsigned long sleepTime) {
+  if (0 == LU_EpochCount) {
+    return;
+  }
+  LU_UpdateClock();
+  uint32_t clock = LU_Clock + (uint32_t)(((millis() - LU_ClockMillis) + sleepTime) / 1000);
+  WriteRtcRecord(RTC_OFFSET_LOGCLOCK, &clock, sizeof(clock));
+}
+
+/**
+ * @brief Writes the records waiting in RAM to flash (before deep sleep or reboot).
+ */
+void FlushLog() {
+  if (LU_Ready && (LU_BatchCount > 0)) {
+    LU_WriteBatch();
+  }
+  SaveLogClock(0);
+}
+
+/**
+ * @brief Gets the number of the records not yet sent.
+ * All segments except the newest one are full.
+ * @return unsigned long The number of the pending records.
+ */
+unsigned long GetLogPendingCount() {
+  unsigned long count = LU_BatchCount;
+
+  if (LU_Ready) {
+    count += ((unsigned long)(LU_LastSeg - LU_ReadPos.segment) * LOG_SEGMENT_RECORDS) + LU_LastSegRecords;
+    count = (count > LU_ReadPos.offset) ? (count - LU_ReadPos.offset) : 0;
+  }
+  return count;
+}
+
+/**
+ * @brief Gets the number of the records dropped because the log was full.
+ * @return unsigned long The number of the dropped records.
+ */
+unsigned long GetLogDropCount() {
+  return LU_Dropped;
+}
+
+/**
+ * @brief Reads the oldest pending records (the read position is not moved).
+ * The flash segments are read first, then the records still waiting in RAM.
+ * @param records Output buffer.
+ * @param maxCount Size of the output buffer [records].
+ * @return UB The number of the read records (0 = nothing pending).
+ */
+UB ReadLog(LogRecord* records, UB maxCount) {
+  char path[LU_PATH_LEN];
+
+  LU_ReadCount = 0;
+  if (!LU_Ready) {
+    return 0;
+  }
+
+  if ((LU_ReadPos.segment == LU_LastSeg) && (LU_ReadPos.offset >= LU_LastSegRecords)) {
+    /* Flash is sent, continue with the RAM batch */
+    LU_ReadCount = (LU_BatchCount < maxCount) ? LU_BatchCount : maxCount;
+    memcpy(records, LU_Batch, LU_ReadCount * sizeof(LogRecord));
+    LU_ReadFromRam = true;
+    return LU_ReadCount;
+  }
+
+  LU_SegmentPath(LU_ReadPos.segment, path);
+  File f = LittleFS.open(path, "r");
+  unsigned long size = f ? (f.size() / sizeof(LogRecord)) : 0;
+
+  if (LU_ReadPos.offset >= size) {
+    /* Older segment completely sent (or missing), continue with the next one */
+    if (f) {
+      f.close();
+    }
+    if (LU_ReadPos.segment < LU_LastSeg) {
+      LU_ReadPos.segment++;
+      LU_ReadPos.offset = 0;
+      while (LU_FirstSeg < LU_ReadPos.segment) {
+        LU_DropFirstSegment();
+      }
+      LU_SaveCursor();
+    }
+    return 0;
+  }
+
+  UB count = ((size - LU_ReadPos.offset) < maxCount) ? (UB)(size - LU_ReadPos.offset) : maxCount;
+  f.seek(LU_ReadPos.offset * sizeof(LogRecord), SeekSet);
+  LU_ReadCount = (UB)(f.read((uint8_t*)records, count * sizeof(LogRecord)) / sizeof(LogRecord));
+  f.close();
+  LU_ReadFromRam = false;
+  return LU_ReadCount;
+}
+
+/**
+ * @brief Moves the read position behind the records returned by ReadLog() (after they were sent).
+ * @param count The number of the sent records.
+ */
+void CommitLogRead(UB count) {
+  if (count > LU_ReadCount) {
+    count = LU_ReadCount;
+  }
+  LU_ReadCount = 0;
+  if (0 == count) {
+    return;
+  }
+
+  if (LU_ReadFromRam) {
+    LU_BatchCount -= count;
+    memmove(LU_Batch, &LU_Batch[count], LU_BatchCount * sizeof(LogRecord));
+  } else {
+    LU_ReadPos.offset += count;
+    LU_SaveCursor();
+  }
+}
+
+#endif /* LOG_ACTIVE */
@@ -0,0 +1,154 @@
+/**
+ * @file LogUtils.h
+ * @brief Header file for the persisted sample log in LittleFS.
+ * Samples which could not be published are appended to a binary log in 
+ * the flash file system and sent to the broker later (backfill). The log 
+ * consists of rotating segment files with fixed-size records, the records 
+ * are collected in RAM and written in page-sized batches.
+ * The records are stamped with the device clock (seconds, kept in the RTC 
+ * memory over resets and deep sleep), which runs also without the network. 
+ * It is converted to the Unix time at the backfill, once SNTP gave the 
+ * offset of the clock epoch (one epoch per power cycle).
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef LOG_UTILS_H
+#define LOG_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <stdint.h>
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+#define LOG_ACTIVE 1 /* 1-Enable / 0-Disable the persisted log of the unsent samples */
+
+/* Flash layout */
+#define LOG_DIR "/log" /* Directory of the segment files */
+#define LOG_PAGE_SIZE 256 /* Flash page size, one write batch [bytes] */
+#define LOG_SEGMENT_RECORDS 4096 /* Records per segment file (32 kB) */
+#define LOG_SEGMENT_COUNT 32 /* Max. number of segments (1 MB), the oldest segment is dropped */
+
+/* Device clock */
+#define LOG_EPOCH_COUNT 8 /* Clock epochs kept for the conversion to the Unix time (older records: time unknown) */
+#define LOG_CLOCK_TOLERANCE 60 /* Max. deviation from the SNTP time, then a new epoch is started [s] */
+
+/* Backfill */
+#define LOG_BACKFILL_CHUNK 16 /* Records per backfill message */
+#define LOG_BACKFILL_PERIOD 1000 /* Min. period of the backfill messages [ms] */
+
+/**
+ * @brief Oldest valid SNTP time (Unix time [s]), older means the clock was not synchronized.
+ */
+#define LOG_TIME_MIN 1700000000UL
+
+// --------------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief One log record (fixed size, stored in flash as is).
+ */
+typedef struct {
+  uint32_t clock; /* Device clock [s] at the sample time (GetLogClock()) */
+  SW tmpr;       /* Temperature [0.01 C] */
+  UW humi;       /* Humidity [0.01 %] */
+} LogRecord;
+
+/**
+ * @brief Records in one write batch (one flash page).
+ * The batch is in RAM until it is full: the records of an incomplete batch 
+ * (max. LOG_BATCH_RECORDS - 1) are lost by a power cut, FlushLog() saves 
+ * them before the deep sleep and the reboot.
+ */
+#define LOG_BATCH_RECORDS (LOG_PAGE_SIZE / sizeof(LogRecord))
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Restores the log position (segments, read cursor), the file system is mounted by the caller.
+ * @param fsMounted Result of the LittleFS mount (false = log disabled).
+ * @return bool True if the log is available.
+ */
+bool Init_Log(bool fsMounted);
+
+/**
+ * @brief Appends one sample to the log (written to flash per LOG_BATCH_RECORDS).
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+void AppendToLog(SL tmpr, SL hum);
+
+/**
+ * @brief Appends one prepared record to the log (e.g. a sample spilled from the MQTT queue).
+ * @param record The record.
+ */
+void AppendRecordToLog(const LogRecord* record);
+
+/**
+ * @brief Converts a millis() time stamp of a sample to the device clock.
+ * @param sampleTime The millis() of the sample [ms].
+ * @return uint32_t The device clock [s].
+ */
+uint32_t GetLogClock(unsigned long sampleTime);
+
+/**
+ * @brief Checks if the Unix time of the current clock epoch is known (learns it from SNTP).
+ * @return bool True if the records of the current epoch can be converted to the Unix time.
+ */
+bool IsLogClockSynced(void);
+
+/**
+ * @brief Converts the device clock of a record to the Unix time (at the backfill).
+ * @param record The record.
+ * @return uint32_t The Unix time [s], 0 if the offset of the record's epoch is not known.
+ */
+uint32_t GetLogRecordTime(const LogRecord* record);
+
+/**
+ * @brief Stores the device clock to the RTC memory (before a reset or the deep sleep).
+ * @param sleepTime The time until the next start (deep sleep time) [ms], 0 for a reset.
+ */
+void SaveLogClock(unsigned long sleepTime);
+
+/**
+ * @brief Writes the records waiting in RAM to flash (before deep sleep or reboot).
+ */
+void FlushLog(void);
+
+/**
+ * @brief Gets the number of the records not yet sent.
+ * @return unsigned long The number of the pending records.
+ */
+unsigned long GetLogPendingCount(void);
+
+/**
+ * @brief Gets the number of the records dropped because the log was full.
+ * @return unsigned long The number of the dropped records.
+ */
+unsigned long GetLogDropCount(void);
+
+/**
+ * @brief Reads the oldest pending records (the read position is not moved).
+ * @param records Output buffer.
+ * @param maxCount Size of the output buffer [records].
+ * @return UB The number of the read records (0 = nothing pending).
+ */
+UB ReadLog(LogRecord* records, UB maxCount);
+
+/**
+ * @brief Moves the read position behind the records returned by ReadLog() (after they were sent).
+ * @param count The number of the sent records.
+ */
+void CommitLogRead(UB count);
+
+#endif // LOG_UTILS_H
@@ -0,0 +1,1013 @@
+/**
+ * @file MqttUtils.cpp
+ * @brief Implementation file for the MQTT connection handling and data publishing.
+ * This file provides the definitions (logic) for the functions 
+ * declared in MqttUtils.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <ESP8266WiFi.h> /* WiFi lib for ESP8266 */
+#include <PubSubClient.h> /* MQTT client */
+#include <ArduinoJson.h> /* JSON lib */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "Global.h"
+#include "MqttUtils.h"
+#include "WifiUtils.h"
+#include "DataUtils.h" /* Temperature trend */
+#include "HistoryUtils.h" /* History query */
+#include "SensorUtils.h" /* Sensor addresses */
+#include "ConfigUtils.h" /* Runtime configuration */
+#include "ConsoleUtils.h" /* Buffered serial log */
+#include "BusUtils.h" /* Sensor fetch reservation */
+
+#if (WIFI_ACTIVE == 1)
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief WiFi Client used by the MQTT client.
+ */
+PRIVATE WiFiClient MU_EspClient;
+
+/**
+ * @brief MQTT client is using WiFI client.
+ */
+PRIVATE PubSubClient MU_Client(MU_EspClient);
+
+/**
+ * @brief Connection state seen in the previous call of Run_Mqtt().
+ */
+PRIVATE bool MU_WasConnected = false;
+
+/**
+ * @brief Current retry delay, doubled after each failed attempt [ms].
+ */
+PRIVATE unsigned long MU_Backoff = MQTT_BACKOFF_MIN;
+
+/**
+ * @brief Time stamp of the last connection attempt [ms].
+ */
+PRIVATE unsigned long MU_LastAttempt = 0;
+
+/**
+ * @brief Delay from the last attempt to the next one (backoff with jitter) [ms].
+ */
+PRIVATE unsigned long MU_RetryDelay = 0;
+
+/**
+ * @brief One buffered sample of the batch (values in hundredths).
+ */
+typedef struct {
+  unsigned long time; /* Sample time stamp (millis) [ms] */
+  SW tmpr;            /* Temperature [0.01 C] */
+  UW hum;             /* Humidity [0.01 %] */
+} MU_BatchSample;
+
+/**
+ * @brief Ring buffer of the samples waiting for the batch message.
+ */
+PRIVATE MU_BatchSample MU_Batch[MQTT_BATCH_SIZE];
+
+/**
+ * @brief Index of the oldest sample and number of the samples in MU_Batch.
+ */
+PRIVATE UB MU_BatchHead = 0;
+PRIVATE UB MU_BatchCount = 0;
+
+/**
+ * @brief Sequence number of the combined/binary telemetry messages (gaps = lost samples).
+ */
+PRIVATE unsigned long MU_Sequence = 0;
+
+/**
+ * @brief Last values sent by PublishData() [0.01 C / 0.01 %] and the send time (deadband reference).
+ * Invalid after a (re)connect, so the first sample of a connection is always sent.
+ */
+PRIVATE SW MU_LastTmpr = 0;
+PRIVATE UW MU_LastHum = 0;
+PRIVATE unsigned long MU_LastPublish = 0;
+PRIVATE bool MU_LastValid = false;
+
+/**
+ * @brief Deadband thresholds [0.01 C / 0.01 %] and the heartbeat [ms] (see SetMqttDeadband()).
+ */
+PRIVATE UW MU_DeadbandTmpr = MQTT_DEADBAND_TMPR;
+PRIVATE UW MU_DeadbandHum = MQTT_DEADBAND_HUM;
+PRIVATE unsigned long MU_Heartbeat = MQTT_HEARTBEAT_TIME;
+
+/**
+ * @brief Number of samples not sent by PublishData() (inside the deadband).
+ */
+PRIVATE unsigned long MU_DeadbandSkipped = 0;
+
+/**
+ * @brief Sequence number of the sensors messages (gaps = lost cycles).
+ */
+PRIVATE unsigned long MU_SensorSequence = 0;
+
+/**
+ * @brief One sample of the offline queue (values in hundredths).
+ */
+typedef struct {
+  unsigned long time; /* Sample time stamp (millis) [ms] */
+  unsigned long seq;  /* Sequence number (shared with the telemetry messages) */
+  SW tmpr;            /* Temperature [0.01 C] */
+  UW hum;             /* Humidity [0.01 %] */
+} MU_QueueSample;
+
+/**
+ * @brief Ring buffer of the samples captured while disconnected.
+ */
+PRIVATE MU_QueueSample MU_Queue[MQTT_QUEUE_SIZE];
+
+/**
+ * @brief Index of the oldest sample and number of the samples in MU_Queue.
+ */
+PRIVATE UW MU_QueueHead = 0;
+PRIVATE UW MU_QueueCount = 0;
+
+/**
+ * @brief Queue statistics (reported by PublishStatus()).
+ */
+PRIVATE unsigned long MU_QueueSpilled = 0; /* Samples moved to the log */
+PRIVATE unsigned long MU_QueueDropped = 0; /* Samples lost (queue full, no log) */
+
+/**
+ * @brief State of the history query being served.
+ * The range is kept as record ages relative to the request time, the 
+ * upper bound moves down with each sent record (records added during 
+ * the transfer are newer than the request and are not included).
+ */
+typedef struct {
+  bool active;
+  UB id;              /* Request ID (echoed in the chunks) */
+  UB tier;            /* HIST_TIER_xxx */
+  UW seq;             /* Next chunk sequence number */
+  uint32_t reqTime;   /* millis() of the request [ms] */
+  uint32_t minAge;    /* Youngest requested record age [ms] */
+  uint32_t maxAge;    /* Oldest record age not sent yet [ms] */
+} MU_HistQuery;
+
+PRIVATE MU_HistQuery MU_History = {false, 0, 0, 0, 0, 0, 0};
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Stores a 16/32-bit value little-endian.
+ */
+PRIVATE void MU_PutUW(UB* dst, UW value) {
+  dst[0] = (UB)(value & 0xFF);
+  dst[1] = (UB)(value >> 8);
+}
+
+PRIVATE void MU_PutU32(UB* dst, uint32_t value) {
+  MU_PutUW(&dst[0], (UW)(value & 0xFFFF));
+  MU_PutUW(&dst[2], (UW)(value >> 16));
+}
+
+/**
+ * @brief Starts a history query (request payload see MQTT_TOPIC_HISTORY_REQ).
+ * A new request replaces the one being served. Swapped bounds are accepted, 
+ * every valid request is answered (at least by the last, empty chunk).
+ */
+PRIVATE void MU_OnHistoryRequest(const UB* payload, unsigned int len) {
+  StaticJsonDocument<128> doc;
+  const uint32_t maxAgeS = (HIST_DAY_COUNT * (HIST_DAY_TIME / 1000UL)); /* Oldest possible record [s] */
+
+  if (deserializeJson(doc, payload, len)) {
+    CONSOLE_WARN("History request: invalid JSON");
+    return;
+  }
+
+  const char* tier = doc["tier"] | "minute";
+  uint32_t from = doc["from"] | maxAgeS;
+  uint32_t to = doc["to"] | 0UL;
+
+  if (0 == strcmp(tier, "hour")) {
+    MU_History.tier = HIST_TIER_HOUR;
+  } else if (0 == strcmp(tier, "day")) {
+    MU_History.tier = HIST_TIER_DAY;
+  } else {
+    MU_History.tier = HIST_TIER_MINUTE;
+  }
+  if (from < to) {
+    /* Bounds given the other way round */
+    uint32_t swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from > maxAgeS) {
+    from = maxAgeS;
+  }
+  if (to > from) {
+    to = from; /* Both bounds limited to the history */
+  }
+
+  MU_History.id = doc["id"] | 0;
+  MU_History.seq = 0;
+  MU_History.reqTime = millis();
+  MU_History.minAge = to * 1000UL;
+  MU_History.maxAge = from * 1000UL;
+  MU_History.active = true;
+}
+
+/**
+ * @brief Publishes the active configuration (retained) on MQTT_TOPIC_CONFIG.
+ * Payload (same keys as the request):
+ * {"alphaNum":3,"alphaDen":100,"period":6000,"display":6000,"publish":6000,
+ *  "trendWindow":360,"dbTmpr":10,"dbHum":100,"heartbeat":300000}
+ */
+PRIVATE void MU_PublishConfig(void) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(9)> doc;
+  const Config* config = GetConfig();
+
+  doc["alphaNum"] = config->alphaNum;
+  doc["alphaDen"] = config->alphaDen;
+  doc["period"] = config->samplePeriod;
+  doc["display"] = config->displayPeriod;
+  doc["publish"] = config->publishPeriod;
+  doc["trendWindow"] = config->trendWindow;
+  doc["dbTmpr"] = config->deadbandTmpr;
+  doc["dbHum"] = config->deadbandHum;
+  doc["heartbeat"] = config->heartbeat;
+
+  if (MU_Client.beginPublish(MQTT_TOPIC_CONFIG, measureJson(doc), true)) {
+    serializeJson(doc, MU_Client);
+    MU_Client.endPublish();
+  }
+}
+
+/**
+ * @brief Updates the configuration (request payload see MU_PublishConfig()).
+ * Missing keys keep their active value, an invalid set is rejected as a 
+ * whole. The active configuration is echoed back in both cases.
+ */
+PRIVATE void MU_OnConfigRequest(const UB* payload, unsigned int len) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(9) + 64> doc;
+  Config config = *GetConfig();
+
+  if (deserializeJson(doc, payload, len)) {
+    CONSOLE_WARN("Config request: invalid JSON");
+    return;
+  }
+
+  config.alphaNum = doc["alphaNum"] | config.alphaNum;
+  config.alphaDen = doc["alphaDen"] | config.alphaDen;
+  config.samplePeriod = doc["period"] | config.samplePeriod;
+  config.displayPeriod = doc["display"] | config.displayPeriod;
+  config.publishPeriod = doc["publish"] | config.publishPeriod;
+  config.trendWindow = doc["trendWindow"] | config.trendWindow;
+  config.deadbandTmpr = doc["dbTmpr"] | config.deadbandTmpr;
+  config.deadbandHum = doc["dbHum"] | config.deadbandHum;
+  config.heartbeat = doc["heartbeat"] | config.heartbeat;
+
+  SetConfig(&config);
+  MU_PublishConfig();
+}
+
+#if (OTA_ACTIVE == 1)
+/**
+ * @brief Starts a firmware update, payload: {"url":"http://192.168.241.111:8080/fw.bin","md5":"<32 hex>"}
+ * ("md5" optional). The result of the request is reported on MQTT_TOPIC_OTA.
+ * An empty payload (the retained request cleared by ClearOtaRequest()) is ignored.
+ */
+PRIVATE void MU_OnOtaRequest(const UB* payload, unsigned int len) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(2) + OTA_URL_LEN + OTA_MD5_LEN + 16> doc;
+
+  if (0 == len) {
+    return;
+  }
+  if (deserializeJson(doc, payload, len)) {
+    CONSOLE_WARN("OTA request: invalid JSON");
+    return;
+  }
+  const char* url = doc["url"] | "";
+  const char* md5 = doc["md5"] | "";
+  if (StartOta(url, md5)) {
+    CONSOLE_INFO("OTA request: %s", url);
+  } else {
+    CONSOLE_WARN("OTA request rejected");
+  }
+  PublishOtaStatus();
+}
+#endif /* OTA_ACTIVE */
+
+/**
+ * @brief Dispatches the received messages by topic.
+ */
+PRIVATE void MU_OnMessage(char* topic, UB* payload, unsigned int len) {
+  if (0 == strcmp(topic, MQTT_TOPIC_HISTORY_REQ)) {
+    MU_OnHistoryRequest(payload, len);
+  } else if (0 == strcmp(topic, MQTT_TOPIC_CONFIG_SET)) {
+    MU_OnConfigRequest(payload, len);
+  }
+#if (OTA_ACTIVE == 1)
+  else if (0 == strcmp(topic, MQTT_TOPIC_OTA_SET)) {
+    MU_OnOtaRequest(payload, len);
+  }
+#endif /* OTA_ACTIVE */
+}
+
+/**
+ * @brief Checks if a history record is in the not yet sent part of the query range.
+ */
+PRIVATE bool MU_IsHistoryInRange(const HistRecord* record) {
+  uint32_t age = MU_History.reqTime - record->time; /* Records newer than the request wrap to a huge age */
+  return (age >= MU_History.minAge) && (age <= MU_History.maxAge);
+}
+
+/**
+ * @brief Checks the deadband: the sample is sent if one of the values moved more 
+ * than its threshold since the last message or the heartbeat time elapsed.
+ * The comparison is done in hundredths, so the float rounding can not flip it.
+ * @param tmpr The temperature [0.01 C].
+ * @param hum The humidity [0.01 %].
+ * @param now The current time [ms].
+ * @return bool True if the sample should be sent.
+ */
+PRIVATE bool MU_IsOutsideDeadband(SW tmpr, UW hum, unsigned long now) {
+  if (!MU_LastValid || ((now - MU_LastPublish) >= MU_Heartbeat)) {
+    return true;
+  }
+  return (abs(tmpr - MU_LastTmpr) > MU_DeadbandTmpr) || (abs((SL)hum - MU_LastHum) > MU_DeadbandHum);
+}
+
+/**
+ * @brief Makes one connection attempt and plans the next one on failure.
+ * The next delay is chosen randomly from <backoff/2, backoff> ("equal jitter"), 
+ * so a fleet of devices does not hit the restarted broker at the same time.
+ */
+PRIVATE void MU_TryConnect(unsigned long now) {
+  MU_LastAttempt = now;
+
+  if (MU_Client.connect(MQTT_CLIENT_ID, "username_optional", "password_optional")) {
+    CONSOLE_INFO("MQTT connected");
+    MU_Client.subscribe(MQTT_TOPIC_HISTORY_REQ);
+    MU_Client.subscribe(MQTT_TOPIC_CONFIG_SET);
+#if (OTA_ACTIVE == 1)
+    MU_Client.subscribe(MQTT_TOPIC_OTA_SET);
+#endif /* OTA_ACTIVE */
+    MU_PublishConfig();
+    /* Publish status on connection (JSON as every message on the status topic) */
+    MU_Client.publish(MQTT_TOPIC_STATUS, "{\"event\":\"connected\"}");
+    MU_Backoff = MQTT_BACKOFF_MIN;
+    MU_WasConnected = true;
+    MU_LastValid = false; /* Subscribers get the current values right after the reconnect */
+    return;
+  }
+
+  MU_RetryDelay = (MU_Backoff / 2) + (unsigned long)random((long)(MU_Backoff / 2) + 1);
+  CONSOLE_WARN("MQTT connection failed, rc=%d try again in %lu ms", MU_Client.state(), MU_RetryDelay);
+
+  MU_Backoff *= 2;
+  if (MU_Backoff > MQTT_BACKOFF_MAX) {
+    MU_Backoff = MQTT_BACKOFF_MAX;
+  }
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Initializes the MQTT client (broker address, timeouts, reconnect state).
+ * The first connection attempt is done on the first call of Run_Mqtt().
+ */
+void Init_Mqtt() {
+  MU_EspClient.setTimeout(MQTT_CONNECT_TIMEOUT);
+  MU_Client.setSocketTimeout(MQTT_SOCKET_TIMEOUT);
+  MU_Client.setServer(MQTT_SERVER, MQTT_PORT);
+  MU_Client.setCallback(MU_OnMessage);
+  MU_WasConnected = false;
+  MU_Backoff = MQTT_BACKOFF_MIN;
+  MU_RetryDelay = 0;
+  MU_LastAttempt = millis();
+}
+
+/**
+ * @brief Runs the MQTT reconnect state machine and the client processing.
+ * States: connected (process packets) / disconnected (wait for the retry delay, 
+ * then make one attempt). No attempt is made while WiFi is down. The blocking 
+ * attempt (max. MQTT_ATTEMPT_TIME) waits until it can not delay the sensor fetch.
+ */
+void Run_Mqtt() {
+  unsigned long now = millis();
+
+  if (MU_Client.connected()) {
+    /* MQTT client processing of incoming/outgoing packets */
+    MU_Client.loop();
+    return;
+  }
+
+  if (MU_WasConnected) {
+    /* Connection just lost, first retry immediately */
+    CONSOLE_WARN("MQTT connection lost.");
+    MU_WasConnected = false;
+    MU_RetryDelay = 0;
+  }
+
+  if (!IsWifiConnected()) {
+    return; /* Nothing to do without WiFi */
+  }
+
+  if (((now - MU_LastAttempt) >= MU_RetryDelay) && IsBusFreeFor(MQTT_ATTEMPT_TIME)) {
+    MU_TryConnect(now);
+  }
+}
+
+/**
+ * @brief Disconnects from the broker (sends the pending data and DISCONNECT).
+ * Used before the deep sleep, the reconnect starts again with the next Init_Mqtt().
+ */
+void DisconnectMqtt() {
+  MU_Client.loop();
+  MU_Client.disconnect();
+  MU_EspClient.flush();
+  MU_WasConnected = false;
+}
+
+/**
+ * @brief Checks if the client is connected to the broker.
+ * @return bool True if connected.
+ */
+bool IsMqttConnected() {
+  return MU_Client.connected();
+}
+
+/**
+ * @brief Publishes temperature, humidity and trend rate as JSON messages on separate topics.
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+PRIVATE void MU_PublishSplit(SL tmpr, SL hum) {
+  /* Create JSON doc with dynamic alocation (max. 100 Bytes) */
+  StaticJsonDocument<100> doc;
+  
+  doc["value"] = FromFx<2>(tmpr);
+  doc["unit"] = "C";
+  
+  /* Serialize JSON na string */
+  char jsonBuffer[100];
+  serializeJson(doc, jsonBuffer);
+  
+  /* Send to MQTT */
+  MU_Client.publish(MQTT_TOPIC_TEMP, jsonBuffer);
+
+  doc.clear();
+
+  doc["value"] = FromFx<2>(hum);
+  doc["unit"] = "%";
+  serializeJson(doc, jsonBuffer);
+  MU_Client.publish(MQTT_TOPIC_HUM, jsonBuffer);
+
+  doc.clear();
+
+  doc["value"] = Quantize<2>(GetTmprTrendRate());
+  doc["unit"] = "C/h";
+  serializeJson(doc, jsonBuffer);
+  MU_Client.publish(MQTT_TOPIC_TREND, jsonBuffer);
+}
+
+/**
+ * @brief Publishes all values as one JSON message on the telemetry topic.
+ * Payload: {"t":24.06,"h":64.98,"tr":1,"rt":0.42,"seq":123}
+ * The document is serialized once, straight into the client output 
+ * (beginPublish/write/endPublish), without any intermediate char buffer.
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+PRIVATE void MU_PublishCombined(SL tmpr, SL hum) {
+  StaticJsonDocument<96> doc;
+
+  doc["t"] = FromFx<2>(tmpr);
+  doc["h"] = FromFx<2>(hum);
+  doc["tr"] = GetTemperatureTrend();
+  doc["rt"] = Quantize<2>(GetTmprTrendRate());
+  doc["seq"] = MU_Sequence++;
+
+  if (MU_Client.beginPublish(MQTT_TOPIC_TELEMETRY, measureJson(doc), false)) {
+    serializeJson(doc, MU_Client);
+    MU_Client.endPublish();
+  }
+}
+
+/**
+ * @brief Publishes all values as one packed binary message (see MQTT_BIN_VERSION).
+ * The values are already in fixed-point hundredths, no text formatting.
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+PRIVATE void MU_PublishBinary(SL tmpr, SL hum) {
+  UB payload[MQTT_BIN_LEN];
+  SW tmprFx = (SW)tmpr; /* Format resolution 0.01 */
+  UW humFx = (UW)hum;
+  UW seq = (UW)MU_Sequence++;
+  SW rateFx = (SW)QuantizeFx<2>(GetTmprTrendRate());
+
+  payload[0] = MQTT_BIN_VERSION;
+  payload[1] = (UB)GetTemperatureTrend();
+  payload[2] = (UB)((UW)tmprFx & 0xFF);
+  payload[3] = (UB)((UW)tmprFx >> 8);
+  payload[4] = (UB)(humFx & 0xFF);
+  payload[5] = (UB)(humFx >> 8);
+  payload[6] = (UB)(seq & 0xFF);
+  payload[7] = (UB)(seq >> 8);
+  payload[8] = (UB)((UW)rateFx & 0xFF);
+  payload[9] = (UB)((UW)rateFx >> 8);
+
+  MU_Client.publish(MQTT_TOPIC_TELEMETRY_BIN, payload, MQTT_BIN_LEN);
+}
+
+/**
+ * @brief Sets the deadband of PublishData() (replaces MQTT_DEADBAND_xxx, e.g. from the config).
+ * The reference of the last message is kept, the new thresholds apply from the next sample.
+ * @param tmpr The temperature deadband [0.01 C].
+ * @param hum The humidity deadband [0.01 %].
+ * @param heartbeat Max. time between two messages [ms].
+ */
+void SetMqttDeadband(UW tmpr, UW hum, unsigned long heartbeat) {
+  MU_DeadbandTmpr = tmpr;
+  MU_DeadbandHum = hum;
+  MU_Heartbeat = heartbeat;
+}
+
+/**
+ * @brief Publishes the measured data to the MQTT broker (format by MQTT_PAYLOAD_FORMAT).
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+bool PublishData(SL tmpr, SL hum) {
+#if (MQTT_DEADBAND_ACTIVE == 1)
+  SW tmprFx = (SW)tmpr;
+  UW humFx = (UW)hum;
+  unsigned long now = millis();
+
+  if (!MU_IsOutsideDeadband(tmprFx, humFx, now)) {
+    MU_DeadbandSkipped++;
+    return false;
+  }
+  MU_LastTmpr = tmprFx;
+  MU_LastHum = humFx;
+  MU_LastPublish = now;
+  MU_LastValid = true;
+#endif /* MQTT_DEADBAND_ACTIVE */
+
+#if (MQTT_PAYLOAD_FORMAT == MQTT_FORMAT_JSON_COMBINED)
+  MU_PublishCombined(tmpr, hum);
+#elif (MQTT_PAYLOAD_FORMAT == MQTT_FORMAT_BINARY)
+  MU_PublishBinary(tmpr, hum);
+#else
+  MU_PublishSplit(tmpr, hum);
+#endif /* MQTT_PAYLOAD_FORMAT */
+  
+  CONSOLE_INFO("MQTT published. T:%.2f, H:%.2f", FromFx<2>(tmpr), FromFx<2>(hum));
+  return true;
+}
+
+/**
+ * @brief Publishes the latest values of all sensor channels as one message on MQTT_TOPIC_SENSORS.
+ * Every channel carries its own topic (MQTT_TOPIC_SENSOR_FMT, derived from 
+ * MQTT_CLIENT_ID), so the flow can route the channels without a mapping table. 
+ * Values in hundredths ([0.01 C], [0.01 %], rate [0.01 C/h]), "ok" false = 
+ * the last measurement of the channel failed (values of the previous cycle):
+ * {"seq":12,"ch":[{"topic":"home/LolinThermometer_01/sensor/0","addr":69,"ok":true,"t":2406,"h":6498,"rt":40},...]}
+ * @param tmpr Filtered temperatures [0.01 C] (SENSOR_COUNT items).
+ * @param hum Filtered humidities [0.01 %] (SENSOR_COUNT items).
+ * @param valid Validity of the last measurement of each channel (SENSOR_COUNT items).
+ * @return bool True if the message was sent.
+ */
+bool PublishSensors(const SL* tmpr, const SL* hum, const bool* valid) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(SENSOR_COUNT) + 
+                     (SENSOR_COUNT * (JSON_OBJECT_SIZE(6) + MQTT_TOPIC_SENSOR_LEN))> doc;
+  char topic[MQTT_TOPIC_SENSOR_LEN];
+
+  if (!MU_Client.connected()) {
+    return false;
+  }
+
+  doc["seq"] = MU_SensorSequence++;
+  JsonArray channels = doc.createNestedArray("ch");
+  for (UB i = 0; i < SENSOR_COUNT; i++) {
+    JsonObject ch = channels.createNestedObject();
+    snprintf(topic, sizeof(topic), MQTT_TOPIC_SENSOR_FMT, i);
+    ch["topic"] = (char*)topic; /* Copied into the document */
+    ch["addr"] = GetSensorAddress(i);
+    ch["ok"] = valid[i];
+    ch["t"] = tmpr[i];
+    ch["h"] = hum[i];
+    ch["rt"] = QuantizeFx<2>(GetSensorTrendRate(i));
+  }
+
+  if (!MU_Client.beginPublish(MQTT_TOPIC_SENSORS, measureJson(doc), false)) {
+    return false;
+  }
+  serializeJson(doc, MU_Client);
+  return (MU_Client.endPublish() != 0);
+}
+
+/**
+ * @brief Stores one sample to the batch ring buffer (oldest sample is overwritten when full).
+ * The values are kept in hundredths, so the message does not need any float formatting.
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+void AddSampleToBatch(SL tmpr, SL hum) {
+  UB idx = (MU_BatchHead + MU_BatchCount) % MQTT_BATCH_SIZE;
+
+  if (MU_BatchCount < MQTT_BATCH_SIZE) {
+    MU_BatchCount++;
+  } else {
+    /* Buffer full, drop the oldest sample */
+    MU_BatchHead = (MU_BatchHead + 1) % MQTT_BATCH_SIZE;
+  }
+
+  MU_Batch[idx].time = millis();
+  MU_Batch[idx].tmpr = (SW)tmpr; /* Format resolution 0.01 */
+  MU_Batch[idx].hum = (UW)hum;
+}
+
+/**
+ * @brief Publishes the buffered samples as one message if the batch is complete 
+ * (MQTT_BATCH_SIZE samples) or the oldest sample is older than MQTT_BATCH_TIME.
+ * Payload (compact JSON, age of the sample in seconds at the send time, values in hundredths):
+ * {"s":[[age,t,h],[age,t,h],...]}  e.g. {"s":[[54,2406,6498],[48,2407,6497]]}
+ * The payload is streamed with beginPublish(), so it is not limited by the client buffer size.
+ * @return bool True if a batch message was sent.
+ */
+bool PublishBatch() {
+  char payload[16 + (MQTT_BATCH_SIZE * 24)];
+  unsigned long now = millis();
+  size_t len;
+
+  if ((0 == MU_BatchCount) || !MU_Client.connected()) {
+    return false;
+  }
+  if ((MU_BatchCount < MQTT_BATCH_SIZE) && ((now - MU_Batch[MU_BatchHead].time) < MQTT_BATCH_TIME)) {
+    return false; /* Batch not due yet */
+  }
+
+  len = snprintf(payload, sizeof(payload), "{\"s\":[");
+  for (UB i = 0; i < MU_BatchCount; i++) {
+    const MU_BatchSample* sample = &MU_Batch[(MU_BatchHead + i) % MQTT_BATCH_SIZE];
+    len += snprintf(&payload[len], sizeof(payload) - len, "%s[%lu,%d,%u]", 
+                    (i > 0) ? "," : "", (now - sample->time) / 1000, sample->tmpr, sample->hum);
+  }
+  len += snprintf(&payload[len], sizeof(payload) - len, "]}");
+
+  if (!MU_Client.beginPublish(MQTT_TOPIC_BATCH, len, false)) {
+    return false; /* Keep the samples for the next try */
+  }
+  MU_Client.write((const uint8_t*)payload, len);
+  if (!MU_Client.endPublish()) {
+    return false;
+  }
+
+  CONSOLE_INFO("MQTT batch published. Samples:%u", MU_BatchCount);
+  MU_BatchHead = 0;
+  MU_BatchCount = 0;
+  return true;
+}
+
+/**
+ * @brief Moves the oldest queued sample to the log (LOG_ACTIVE) or drops it.
+ * The record gets the device clock of the capture time (not of the spill), 
+ * so also the samples queued before the SNTP synchronization keep their time.
+ */
+PRIVATE void MU_SpillOldest(void) {
+  const MU_QueueSample* oldest = &MU_Queue[MU_QueueHead];
+#if (LOG_ACTIVE == 1)
+  LogRecord rec;
+  rec.clock = GetLogClock(oldest->time);
+  rec.tmpr = oldest->tmpr;
+  rec.humi = oldest->hum;
+  AppendRecordToLog(&rec);
+  MU_QueueSpilled++;
+#else
+  (void)oldest;
+  MU_QueueDropped++;
+#endif /* LOG_ACTIVE */
+  MU_QueueHead = (MU_QueueHead + 1) % MQTT_QUEUE_SIZE;
+  MU_QueueCount--;
+}
+
+/**
+ * @brief Stores one sample captured while disconnected to the offline queue.
+ * When the queue is full, the oldest sample is spilled to the log (LOG_ACTIVE) or dropped.
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+void QueueSample(SL tmpr, SL hum) {
+  if (MU_QueueCount >= MQTT_QUEUE_SIZE) {
+    MU_SpillOldest();
+  }
+
+  MU_QueueSample* sample = &MU_Queue[(MU_QueueHead + MU_QueueCount) % MQTT_QUEUE_SIZE];
+  sample->time = millis();
+  sample->seq = MU_Sequence++;
+  sample->tmpr = (SW)tmpr; /* Format resolution 0.01 */
+  sample->hum = (UW)hum;
+  MU_QueueCount++;
+}
+
+/**
+ * @brief Publishes the oldest queued samples as one replay message (MQTT_QUEUE_CHUNK samples).
+ * Payload on the batch topic (age [s] at the send time, values in hundredths, sequence number):
+ * {"s":[[age,t,h,seq],...]}  e.g. {"s":[[54,2406,6498,17],[48,2407,6497,18]]}
+ * PubSubClient publishes with QoS 0 only, so the samples are removed after 
+ * the message was completely written to the connection; the receiver can 
+ * detect gaps and duplicates by the sequence number.
+ * @return bool True if a message was sent.
+ */
+bool DrainQueue() {
+  char payload[16 + (MQTT_QUEUE_CHUNK * 40)];
+  unsigned long now = millis();
+  UW count = (MU_QueueCount < MQTT_QUEUE_CHUNK) ? MU_QueueCount : MQTT_QUEUE_CHUNK;
+  size_t len;
+
+  if ((0 == count) || !MU_Client.connected()) {
+    return false;
+  }
+
+  len = snprintf(payload, sizeof(payload), "{\"s\":[");
+  for (UW i = 0; i < count; i++) {
+    const MU_QueueSample* sample = &MU_Queue[(MU_QueueHead + i) % MQTT_QUEUE_SIZE];
+    len += snprintf(&payload[len], sizeof(payload) - len, "%s[%lu,%d,%u,%lu]", 
+                    (i > 0) ? "," : "", (now - sample->time) / 1000, sample->tmpr, sample->hum, sample->seq);
+  }
+  len += snprintf(&payload[len], sizeof(payload) - len, "]}");
+
+  if (!MU_Client.beginPublish(MQTT_TOPIC_BATCH, len, false)) {
+    return false; /* Keep the samples for the next try */
+  }
+  MU_Client.write((const uint8_t*)payload, len);
+  if (!MU_Client.endPublish()) {
+    return false;
+  }
+
+  MU_QueueHead = (MU_QueueHead + count) % MQTT_QUEUE_SIZE;
+  MU_QueueCount -= count;
+  return true;
+}
+
+#if (LOG_ACTIVE == 1)
+/**
+ * @brief Moves all queued samples to the log (before a reboot, the RAM queue is lost by it).
+ * The log batch has to be flushed by the caller (FlushLog()).
+ */
+void SpillQueue() {
+  while (MU_QueueCount > 0) {
+    MU_SpillOldest();
+  }
+}
+#endif /* LOG_ACTIVE */
+
+/**
+ * @brief Gets the number of the samples in the offline queue.
+ * @return UW The queue depth.
+ */
+UW GetQueueCount() {
+  return MU_QueueCount;
+}
+
+/**
+ * @brief Checks if a history query is being served.
+ * @return bool True if there are chunks left to send.
+ */
+bool IsHistoryQueryPending() {
+  return MU_History.active;
+}
+
+/**
+ * @brief Sends the next chunk of the current history query (call every MQTT_HIST_PERIOD).
+ * The records are read twice from the history rings (count, then write), 
+ * so the message is streamed into the client in 16-byte pieces and no 
+ * response buffer is needed.
+ */
+void ServeHistoryQuery() {
+  HistRecord record;
+  UB header[MQTT_HIST_HEADER_LEN];
+  UB item[MQTT_HIST_RECORD_LEN];
+  UW total = GetHistoryCount(MU_History.tier);
+  UW matching = 0;
+
+  if (!MU_History.active || !MU_Client.connected()) {
+    return;
+  }
+
+  /* Pass 1: number of the remaining records (oldest = highest index) */
+  for (UW idx = total; idx > 0; idx--) {
+    if (GetHistoryRecord(MU_History.tier, idx - 1, &record) && MU_IsHistoryInRange(&record)) {
+      matching++;
+    }
+  }
+  UW count = (matching > MQTT_HIST_CHUNK) ? MQTT_HIST_CHUNK : matching;
+  bool last = (count == matching);
+
+  header[0] = MQTT_HIST_VERSION;
+  header[1] = MU_History.id;
+  header[2] = MU_History.tier;
+  header[3] = last ? 1 : 0;
+  MU_PutUW(&header[4], MU_History.seq);
+  MU_PutUW(&header[6], count);
+
+  if (!MU_Client.beginPublish(MQTT_TOPIC_HISTORY, MQTT_HIST_HEADER_LEN + (count * MQTT_HIST_RECORD_LEN), false)) {
+    return; /* Retry on the next call */
+  }
+  MU_Client.write(header, sizeof(header));
+
+  /* Pass 2: stream the first 'count' remaining records */
+  uint32_t now = millis();
+  uint32_t nextMaxAge = MU_History.maxAge;
+  UW sent = 0;
+  for (UW idx = total; (idx > 0) && (sent < count); idx--) {
+    if (!GetHistoryRecord(MU_History.tier, idx - 1, &record) || !MU_IsHistoryInRange(&record)) {
+      continue;
+    }
+    MU_PutU32(&item[0], (now - record.time) / 1000UL);
+    MU_PutUW(&item[4], (UW)record.tmprMin);
+    MU_PutUW(&item[6], (UW)record.tmprMax);
+    MU_PutUW(&item[8], (UW)record.tmprMean);
+    MU_PutUW(&item[10], record.humiMin);
+    MU_PutUW(&item[12], record.humiMax);
+    MU_PutUW(&item[14], record.humiMean);
+    MU_Client.write(item, sizeof(item));
+    nextMaxAge = MU_History.reqTime - record.time;
+    sent++;
+  }
+
+  if (!MU_Client.endPublish()) {
+    return; /* Chunk not sent, the cursor stays */
+  }
+
+  MU_History.seq++;
+  if (last || (0 == nextMaxAge) || ((nextMaxAge - 1) < MU_History.minAge)) {
+    MU_History.active = false;
+  } else {
+    MU_History.maxAge = nextMaxAge - 1;
+  }
+}
+
+/**
+ * @brief Publishes the device status (queue, log and sensor fault statistics) on the status topic.
+ * Payload: {"queue":0,"queueMax":120,"spilled":0,"dropped":0,"log":0,"logDropped":0,"skipped":0,
+ *           "readErr":0,"rangeErr":0,"outliers":0,"sensorResets":0,"resetDetects":0,"heaterOffs":0,
+ *           "alerts":0,"statusErr":0}
+ * ("skipped" = samples inside the deadband, all counters since the boot)
+ */
+void PublishStatus() {
+  StaticJsonDocument<JSON_OBJECT_SIZE(15)> doc;
+  const SensorFaults* faults = GetSensorFaults();
+
+  if (!MU_Client.connected()) {
+    return;
+  }
+
+  doc["queue"] = MU_QueueCount;
+  doc["queueMax"] = MQTT_QUEUE_SIZE;
+  doc["spilled"] = MU_QueueSpilled;
+  doc["dropped"] = MU_QueueDropped;
+  doc["skipped"] = MU_DeadbandSkipped;
+  doc["readErr"] = faults->readErrors;
+  doc["rangeErr"] = GetRangeErrorCount();
+  doc["outliers"] = GetOutlierCount();
+  doc["sensorResets"] = faults->softResets;
+  doc["resetDetects"] = faults->resetDetects;
+  doc["heaterOffs"] = faults->heaterOffs;
+  doc["alerts"] = faults->alerts;
+  doc["statusErr"] = faults->statusErrors;
+#if (LOG_ACTIVE == 1)
+  doc["log"] = GetLogPendingCount();
+  doc["logDropped"] = GetLogDropCount();
+#endif /* LOG_ACTIVE */
+
+  if (MU_Client.beginPublish(MQTT_TOPIC_STATUS, measureJson(doc), false)) {
+    serializeJson(doc, MU_Client);
+    MU_Client.endPublish();
+  }
+}
+
+#if (OTA_ACTIVE == 1)
+/**
+ * @brief Deletes a retained update request on the broker (empty retained message on MQTT_TOPIC_OTA_SET).
+ * Called before the reboot into the new image, so the request is not received again after the boot.
+ */
+void ClearOtaRequest() {
+  if (MU_Client.connected()) {
+    MU_Client.publish(MQTT_TOPIC_OTA_SET, (const uint8_t*)"", 0, true);
+  }
+}
+
+/**
+ * @brief Publishes the state of the firmware update on MQTT_TOPIC_OTA (running firmware included).
+ * Payload: {"fw":"Oct 14 2026 10:00:00","state":"download","progress":102400,"size":412000,"error":""}
+ */
+void PublishOtaStatus() {
+  static const char* const states[] = {"idle", "connect", "header", "download", "done", "error"};
+  StaticJsonDocument<JSON_OBJECT_SIZE(5)> doc;
+  UB state = GetOtaState();
+
+  if (!MU_Client.connected()) {
+    return;
+  }
+
+  doc["fw"] = __DATE__ " " __TIME__;
+  doc["state"] = (state < (sizeof(states) / sizeof(states[0]))) ? states[state] : "?";
+  doc["progress"] = GetOtaProgress();
+  doc["size"] = GetOtaSize();
+  doc["error"] = GetOtaError();
+
+  if (MU_Client.beginPublish(MQTT_TOPIC_OTA, measureJson(doc), false)) {
+    serializeJson(doc, MU_Client);
+    MU_Client.endPublish();
+  }
+}
+#endif /* OTA_ACTIVE */
+
+#if (PROF_ACTIVE == 1)
+/**
+ * @brief Publishes the timing statistics with the heap and WiFi state on the status topic.
+ * The firmware is identified by its build time stamp. Durations in [us], 
+ * "hist" = number of spans <100 us, <1 ms, <10 ms, >=10 ms. Payload e.g.:
+ * {"fw":"Oct 14 2026 10:00:00","up":300,"heap":31200,"heapFrag":4,"maxBlock":29000,"rssi":-61,
+ *  "spans":{"sensor":{"n":50,"min":410,"max":520,"mean":430,"hist":[0,50,0,0]},...}}
+ * The statistics are cleared after the report (one window per report).
+ */
+void PublishProfile() {
+  StaticJsonDocument<JSON_OBJECT_SIZE(7) + JSON_OBJECT_SIZE(PROF_SPAN_COUNT) + 
+                     (PROF_SPAN_COUNT * (JSON_OBJECT_SIZE(5) + JSON_ARRAY_SIZE(PROF_HIST_COUNT)))> doc;
+
+  if (!MU_Client.connected()) {
+    return;
+  }
+
+  doc["fw"] = __DATE__ " " __TIME__;
+  doc["up"] = millis() / 1000;
+  doc["heap"] = ESP.getFreeHeap();
+  doc["heapFrag"] = ESP.getHeapFragmentation();
+  doc["maxBlock"] = ESP.getMaxFreeBlockSize();
+  doc["rssi"] = WiFi.RSSI();
+
+  JsonObject spans = doc.createNestedObject("spans");
+  for (UB i = 0; i < PROF_SPAN_COUNT; i++) {
+    const ProfStats* stats = GetProfileStats(i);
+    JsonObject span = spans.createNestedObject(GetProfileSpanName(i));
+    span["n"] = stats->count;
+    span["min"] = ProfileCyclesToUs(stats->minCycles);
+    span["max"] = ProfileCyclesToUs(stats->maxCycles);
+    span["mean"] = (stats->count > 0) ? ProfileCyclesToUs(stats->sumCycles / stats->count) : 0;
+    JsonArray hist = span.createNestedArray("hist");
+    for (UB b = 0; b < PROF_HIST_COUNT; b++) {
+      hist.add(stats->hist[b]);
+    }
+  }
+
+  if (MU_Client.beginPublish(MQTT_TOPIC_STATUS, measureJson(doc), false) && 
+      (serializeJson(doc, MU_Client) > 0) && MU_Client.endPublish()) {
+    ResetProfile();
+  }
+}
+#endif /* PROF_ACTIVE */
+
+/**
+ * @brief Publishes logged samples (backfill after an outage) as one message.
+ * Payload (compact JSON, Unix time of the sample [s], values in hundredths):
+ * {"s":[[ts,t,h],[ts,t,h],...]}  e.g. {"s":[[1760443200,2406,6498]]}
+ * The device clock of the records is converted here (GetLogRecordTime()), 
+ * ts = 0 if the Unix offset of the record's clock epoch is not known.
+ * @param records The logged samples.
+ * @param count The number of the samples.
+ * @return bool True if the message was sent.
+ */
+bool PublishLogRecords(const LogRecord* records, UB count) {
+  char payload[16 + (LOG_BACKFILL_CHUNK * 28)];
+  size_t len;
+
+  if ((0 == count) || (count > LOG_BACKFILL_CHUNK) || !MU_Client.connected()) {
+    return false;
+  }
+
+  len = snprintf(payload, sizeof(payload), "{\"s\":[");
+  for (UB i = 0; i < count; i++) {
+    len += snprintf(&payload[len], sizeof(payload) - len, "%s[%lu,%d,%u]", 
+                    (i > 0) ? "," : "", (unsigned long)GetLogRecordTime(&records[i]), records[i].tmpr, records[i].humi);
+  }
+  len += snprintf(&payload[len], sizeof(payload) - len, "]}");
+
+  if (!MU_Client.beginPublish(MQTT_TOPIC_BACKFILL, len, false)) {
+    return false;
+  }
+  MU_Client.write((const uint8_t*)payload, len);
+  return (MU_Client.endPublish() != 0);
+}
+#endif /* WIFI_ACTIVE */
@@ -0,0 +1,260 @@
+/**
+ * @file MqttUtils.h
+ * @brief Header file for the MQTT connection handling and data publishing.
+ * The connection to the broker is maintained by a non-blocking state 
+ * machine with jittered exponential backoff, so the measurement keeps 
+ * running while the broker is not reachable.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef MQTT_UTILS_H
+#define MQTT_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include "Global.h"
+#include "LogUtils.h" /* LogRecord */
+#include "ProfileUtils.h" /* PROF_ACTIVE */
+#include "OtaUtils.h" /* OTA_ACTIVE */
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+/* MQTT broker (Mosquitto) on Raspberry Pi */
+#define MQTT_SERVER "192.168.241.111" /* IP address Raspberry Pi (Mosquitto Broker) */
+#define MQTT_PORT 1883
+#define MQTT_CLIENT_ID "LolinThermometer_01" /* Unique ID for this senzor */
+#define MQTT_TOPIC_TEMP "home/thermometer/temperature"
+#define MQTT_TOPIC_HUM "home/thermometer/humidity"
+#define MQTT_TOPIC_TREND "home/thermometer/trend"
+#define MQTT_TOPIC_STATUS "home/thermometer/status"
+#define MQTT_TOPIC_BATCH "home/thermometer/batch"
+#define MQTT_TOPIC_TELEMETRY "home/thermometer/telemetry"
+#define MQTT_TOPIC_TELEMETRY_BIN "home/thermometer/telemetry/bin"
+#define MQTT_TOPIC_BACKFILL "home/thermometer/backfill"
+#define MQTT_TOPIC_HISTORY_REQ "home/thermometer/history/get" /* History query (subscribed) */
+#define MQTT_TOPIC_HISTORY "home/thermometer/history" /* History response chunks (binary) */
+#define MQTT_TOPIC_CONFIG_SET "home/thermometer/config/set" /* New configuration (retained, subscribed) */
+#define MQTT_TOPIC_CONFIG "home/thermometer/config" /* Active configuration (retained) */
+#define MQTT_TOPIC_OTA_SET "home/thermometer/ota/set" /* Firmware update request (subscribed, a retained one is cleared before the reboot) */
+#define MQTT_TOPIC_OTA "home/thermometer/ota" /* Firmware update progress */
+#define MQTT_TOPIC_SENSORS "home/" MQTT_CLIENT_ID "/sensors" /* All sensor channels (SENSOR_COUNT > 1) */
+#define MQTT_TOPIC_SENSOR_FMT "home/" MQTT_CLIENT_ID "/sensor/%u" /* Topic of one channel (in the sensors message) */
+#define MQTT_TOPIC_SENSOR_LEN 48 /* Buffer size of one channel topic */
+
+/* Payload format of PublishData() */
+#define MQTT_FORMAT_JSON_SPLIT 0 /* Two JSON messages (temperature and humidity topic) */
+#define MQTT_FORMAT_JSON_COMBINED 1 /* One JSON message with all values on the telemetry topic */
+#define MQTT_FORMAT_BINARY 2 /* One packed fixed-point binary message (8 bytes) */
+#define MQTT_PAYLOAD_FORMAT MQTT_FORMAT_JSON_SPLIT /* Selected payload format */
+
+/* Report-by-exception (deadband) publishing of PublishData() */
+#define MQTT_DEADBAND_ACTIVE 0 /* 1-Enable / 0-Disable deadband publishing */
+#define MQTT_DEADBAND_TMPR 10 /* Default min. change of the temperature since the last message [0.01 C] */
+#define MQTT_DEADBAND_HUM 100 /* Default min. change of the humidity since the last message [0.01 %] */
+#define MQTT_HEARTBEAT_TIME 300000 /* Default max. time between two messages (also without a change) [ms] */
+
+/* Batched publishing configuration */
+#define MQTT_BATCH_ACTIVE 0 /* 1-Enable / 0-Disable batched publishing (one message per N samples) */
+#define MQTT_BATCH_SIZE 10 /* Number of samples in one batch message (N) */
+#define MQTT_BATCH_TIME 60000 /* Max. age of the oldest buffered sample (T) [ms] */
+
+/* Store-and-forward queue configuration (samples captured while disconnected) */
+#define MQTT_QUEUE_ACTIVE 1 /* 1-Enable / 0-Disable the offline queue */
+#define MQTT_QUEUE_SIZE 120 /* RAM queue length [samples] (12 min at 6 s), then spilled to the log */
+#define MQTT_QUEUE_CHUNK 10 /* Samples per replay message */
+#define MQTT_QUEUE_DRAIN_PERIOD 250 /* Min. period of the replay messages [ms] */
+
+/* Status reporting */
+#define MQTT_STATUS_PERIOD 60000 /* Period of the status message [ms] */
+
+/* Reconnect backoff configuration */
+#define MQTT_BACKOFF_MIN 1000 /* First retry delay after a failed attempt [ms] */
+#define MQTT_BACKOFF_MAX 60000 /* Maximal retry delay [ms] */
+#define MQTT_CONNECT_TIMEOUT 300 /* TCP connect timeout of one attempt (blocks the scheduler, broker in the LAN) [ms] */
+#define MQTT_SOCKET_TIMEOUT 1 /* Max. wait for a reply packet, e.g. CONNACK (PubSubClient resolution) [s] */
+#define MQTT_ATTEMPT_TIME (MQTT_CONNECT_TIMEOUT + (MQTT_SOCKET_TIMEOUT * 1000UL)) /* Max. blocking time of one attempt [ms] */
+
+/**
+ * @brief Binary telemetry format (MQTT_FORMAT_BINARY), all values little-endian:
+ * | Byte | Type | Value                             |
+ * |------|------|-----------------------------------|
+ * | 0    | UB   | Format version (MQTT_BIN_VERSION) |
+ * | 1    | SB   | Trend (1 / 0 / -1)                |
+ * | 2-3  | SW   | Temperature [0.01 C]              |
+ * | 4-5  | UW   | Humidity [0.01 %]                 |
+ * | 6-7  | UW   | Sequence number (wraps)           |
+ * | 8-9  | SW   | Trend rate [0.01 C/h] (version 2) |
+ */
+#define MQTT_BIN_VERSION 2
+#define MQTT_BIN_LEN 10
+
+/**
+ * @brief History query (MQTT_TOPIC_HISTORY_REQ), JSON request, ages in seconds before now:
+ * {"id":7,"tier":"hour","from":86400,"to":0}   (tier: "minute" / "hour" / "day")
+ * The records in the range are sent oldest first in binary chunks on 
+ * MQTT_TOPIC_HISTORY (one chunk per MQTT_HIST_PERIOD), little-endian:
+ * | Byte | Type | Value                                   |
+ * |------|------|-----------------------------------------|
+ * | 0    | UB   | Format version (MQTT_HIST_VERSION)      |
+ * | 1    | UB   | Request ID                              |
+ * | 2    | UB   | Tier (HIST_TIER_xxx)                    |
+ * | 3    | UB   | Flags (bit 0: last chunk)               |
+ * | 4-5  | UW   | Chunk sequence number (0 = first)       |
+ * | 6-7  | UW   | Number of records in the chunk          |
+ * followed by the records (MQTT_HIST_RECORD_LEN bytes each):
+ * | 0-3  | u32  | Age of the interval start [s]           |
+ * | 4-9  | SW   | Temperature min / max / mean [0.01 C]   |
+ * | 10-15| UW   | Humidity min / max / mean [0.01 %]      |
+ * Swapped bounds are accepted. An empty range is answered by one chunk 
+ * without records (last flag set).
+ */
+#define MQTT_HIST_VERSION 1
+#define MQTT_HIST_HEADER_LEN 8
+#define MQTT_HIST_RECORD_LEN 16
+#define MQTT_HIST_CHUNK 16 /* Records per chunk (264 B message) */
+#define MQTT_HIST_PERIOD 100 /* Min. period of the chunks [ms] */
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Initializes the MQTT client (broker address, timeouts, reconnect state).
+ */
+void Init_Mqtt(void);
+
+/**
+ * @brief Runs the MQTT reconnect state machine and the client processing.
+ * Makes at most one connection attempt per call, never waits for the retry.
+ */
+void Run_Mqtt(void);
+
+/**
+ * @brief Disconnects from the broker (sends the pending data and DISCONNECT).
+ */
+void DisconnectMqtt(void);
+
+/**
+ * @brief Checks if the client is connected to the broker.
+ * @return bool True if connected.
+ */
+bool IsMqttConnected(void);
+
+/**
+ * @brief Sets the deadband of PublishData() (replaces MQTT_DEADBAND_xxx, e.g. from the config).
+ * @param tmpr The temperature deadband [0.01 C].
+ * @param hum The humidity deadband [0.01 %].
+ * @param heartbeat Max. time between two messages [ms].
+ */
+void SetMqttDeadband(UW tmpr, UW hum, unsigned long heartbeat);
+
+/**
+ * @brief Publishes the measured data to the MQTT broker (format by MQTT_PAYLOAD_FORMAT).
+ * With MQTT_DEADBAND_ACTIVE only a change beyond the deadband or the heartbeat is sent.
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ * @return bool True if a message was sent (false = suppressed by the deadband).
+ */
+bool PublishData(SL tmpr, SL hum);
+
+/**
+ * @brief Publishes the latest values of all sensor channels as one message.
+ * @param tmpr Filtered temperatures [0.01 C] (SENSOR_COUNT items).
+ * @param hum Filtered humidities [0.01 %] (SENSOR_COUNT items).
+ * @param valid Validity of the last measurement of each channel (SENSOR_COUNT items).
+ * @return bool True if the message was sent.
+ */
+bool PublishSensors(const SL* tmpr, const SL* hum, const bool* valid);
+
+/**
+ * @brief Stores one sample to the batch ring buffer (oldest sample is overwritten when full).
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+void AddSampleToBatch(SL tmpr, SL hum);
+
+/**
+ * @brief Publishes the buffered samples as one message if the batch is complete 
+ * (MQTT_BATCH_SIZE samples) or the oldest sample is older than MQTT_BATCH_TIME.
+ * @return bool True if a batch message was sent.
+ */
+bool PublishBatch(void);
+
+/**
+ * @brief Stores one sample captured while disconnected to the offline queue.
+ * When the queue is full, the oldest sample is spilled to the log (LOG_ACTIVE) or dropped.
+ * @param tmpr Temperature value [0.01 C].
+ * @param hum Humidity value [0.01 %].
+ */
+void QueueSample(SL tmpr, SL hum);
+
+/**
+ * @brief Publishes the oldest queued samples as one replay message (MQTT_QUEUE_CHUNK samples).
+ * @return bool True if a message was sent.
+ */
+bool DrainQueue(void);
+
+#if (LOG_ACTIVE == 1)
+/**
+ * @brief Moves all queued samples to the log (before a reboot, the RAM queue is lost by it).
+ */
+void SpillQueue(void);
+#endif /* LOG_ACTIVE */
+
+/**
+ * @brief Gets the number of the samples in the offline queue.
+ * @return UW The queue depth.
+ */
+UW GetQueueCount(void);
+
+/**
+ * @brief Publishes the device status (queue, log and sensor fault statistics) on the status topic.
+ */
+void PublishStatus(void);
+
+/**
+ * @brief Publishes logged samples (backfill after an outage) as one message.
+ * @param records The logged samples.
+ * @param count The number of the samples.
+ * @return bool True if the message was sent.
+ */
+bool PublishLogRecords(const LogRecord* records, UB count);
+
+/**
+ * @brief Checks if a history query is being served.
+ * @return bool True if there are chunks left to send.
+ */
+bool IsHistoryQueryPending(void);
+
+/**
+ * @brief Sends the next chunk of the current history query (call every MQTT_HIST_PERIOD).
+ */
+void ServeHistoryQuery(void);
+
+#if (OTA_ACTIVE == 1)
+/**
+ * @brief Publishes the state of the firmware update on MQTT_TOPIC_OTA.
+ */
+void PublishOtaStatus(void);
+
+/**
+ * @brief Deletes a retained update request on the broker (before the reboot into the new image).
+ */
+void ClearOtaRequest(void);
+#endif /* OTA_ACTIVE */
+
+#if (PROF_ACTIVE == 1)
+/**
+ * @brief Publishes the timing statistics with the heap and WiFi state on the status topic.
+ * The statistics are cleared after the report (one window per report).
+ */
+void PublishProfile(void);
+#endif /* PROF_ACTIVE */
+
+#endif // MQTT_UTILS_H
@@ -0,0 +1,405 @@
+/**
+ * @file OtaUtils.cpp
+ * @brief Implementation file for the non-blocking HTTP firmware update.
+ * This file provides the definitions (logic) for the functions
+ * declared in OtaUtils.h.
+ * The image is requested by HTTP/1.0 (no chunked transfer encoding), the
+ * response header is parsed line by line as the data arrive, the body
+ * goes to the Updater (MD5 checked at the end). The states never wait for
+ * the network, except the TCP connect: the server is given by its IP 
+ * address (no DNS lookup), the connect waits max. OTA_CONNECT_TIMEOUT and 
+ * starts only when no sensor fetch is due within that time.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <ESP8266WiFi.h> /* WiFi lib for ESP8266 */
+#include <Updater.h> /* Flash update of the sketch */
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+#include "Global.h"
+#include "OtaUtils.h"
+#include "BusUtils.h" /* Sensor fetch reservation */
+#include "ConsoleUtils.h" /* Buffered serial log */
+
+#if (OTA_ACTIVE == 1)
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+#define OU_URL_PREFIX "http://"
+#define OU_HOST_LEN 64 /* Max. host name length */
+#define OU_HTTP_PORT 80
+#define OU_REQUEST_LEN (OTA_URL_LEN + OU_HOST_LEN + 48) /* GET line, Host and Connection header */
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Connection to the HTTP server.
+ */
+PRIVATE WiFiClient OU_Client;
+
+/**
+ * @brief Parsed image URL and the expected MD5.
+ */
+PRIVATE char OU_Host[OU_HOST_LEN + 1];
+PRIVATE IPAddress OU_Ip;
+PRIVATE UW OU_Port = OU_HTTP_PORT;
+PRIVATE char OU_Path[OTA_URL_LEN + 1];
+PRIVATE char OU_Md5[OTA_MD5_LEN + 1];
+
+/**
+ * @brief Update state (OTA_STATE_xxx) and the error reason.
+ */
+PRIVATE UB OU_State = OTA_STATE_IDLE;
+PRIVATE const char* OU_Error = "";
+
+/**
+ * @brief Header line being received, HTTP status code (0 = status line not received).
+ */
+PRIVATE char OU_Line[OTA_LINE_LEN];
+PRIVATE UW OU_LineLen = 0;
+PRIVATE UW OU_HttpStatus = 0;
+
+/**
+ * @brief Image size, written bytes and the time of the last received data [ms].
+ */
+PRIVATE uint32_t OU_Size = 0;
+PRIVATE uint32_t OU_Written = 0;
+PRIVATE unsigned long OU_LastData = 0;
+
+/**
+ * @brief The Updater was started (must be closed on a failure).
+ */
+PRIVATE bool OU_UpdateStarted = false;
+
+/**
+ * @brief Chunk buffer (one flash write).
+ */
+PRIVATE UB OU_Buffer[OTA_CHUNK_SIZE];
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Stops the update with an error, the running firmware stays.
+ * @param error The error text (string literal).
+ */
+PRIVATE void OU_Fail(const char* error) {
+  if (OU_UpdateStarted) {
+    Update.end(); /* Not finished: the image is discarded */
+    OU_UpdateStarted = false;
+  }
+  OU_Client.stop();
+  OU_Error = error;
+  OU_State = OTA_STATE_ERROR;
+  CONSOLE_ERROR("OTA failed: %s", error);
+}
+
+/**
+ * @brief Splits the URL "http://a.b.c.d[:port]/path" into OU_Host (OU_Ip), OU_Port and OU_Path.
+ * A host name is not accepted, its DNS lookup would block the scheduler.
+ * @param url The image URL.
+ * @return bool True if the URL is valid.
+ */
+PRIVATE bool OU_ParseUrl(const char* url) {
+  const size_t prefixLen = strlen(OU_URL_PREFIX);
+
+  if ((NULL == url) || (0 != strncmp(url, OU_URL_PREFIX, prefixLen)) || (strlen(url) > OTA_URL_LEN)) {
+    return false;
+  }
+  const char* host = url + prefixLen;
+  const char* path = strchr(host, '/');
+  if (NULL == path) {
+    return false;
+  }
+  const char* port = (const char*)memchr(host, ':', path - host);
+  size_t hostLen = (NULL != port) ? (size_t)(port - host) : (size_t)(path - host);
+  if ((0 == hostLen) || (hostLen > OU_HOST_LEN)) {
+    return false;
+  }
+
+  memcpy(OU_Host, host, hostLen);
+  OU_Host[hostLen] = '\0';
+  if (!OU_Ip.fromString(OU_Host)) {
+    return false;
+  }
+  OU_Port = OU_HTTP_PORT;
+  if (NULL != port) {
+    unsigned long value = strtoul(port + 1, NULL, 10);
+    if ((0 == value) || (value > 0xFFFF)) {
+      return false;
+    }
+    OU_Port = (UW)value;
+  }
+  strncpy(OU_Path, path, OTA_URL_LEN);
+  OU_Path[OTA_URL_LEN] = '\0';
+  return true;
+}
+
+/**
+ * @brief Checks the MD5 string of the request (exactly OTA_MD5_LEN hex digits).
+ * @param md5 The MD5 string.
+ * @return bool True if the string is valid.
+ */
+PRIVATE bool OU_IsMd5Valid(const char* md5) {
+  if (OTA_MD5_LEN != strlen(md5)) {
+    return false;
+  }
+  for (UB i = 0; i < OTA_MD5_LEN; i++) {
+    if (!isxdigit((unsigned char)md5[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Connects to the server and sends the request.
+ * Waits until the connect (max. OTA_CONNECT_TIMEOUT) can not delay the sensor fetch.
+ */
+PRIVATE void OU_Connect(void) {
+  char request[OU_REQUEST_LEN];
+
+  if (!IsBusFreeFor(OTA_CONNECT_TIMEOUT)) {
+    return;
+  }
+  OU_Client.setTimeout(OTA_CONNECT_TIMEOUT);
+  if (!OU_Client.connect(OU_Ip, OU_Port)) {
+    OU_Fail("connect");
+    return;
+  }
+  int len = snprintf(request, sizeof(request), "GET %s HTTP/1.0\r\nHost: %s\r\nConnection: close\r\n\r\n", OU_Path, OU_Host);
+  OU_Client.write((const uint8_t*)request, (size_t)len);
+
+  OU_LineLen = 0;
+  OU_HttpStatus = 0;
+  OU_Size = 0;
+  OU_Written = 0;
+  OU_LastData = millis();
+  OU_State = OTA_STATE_HEADER;
+}
+
+/**
+ * @brief Processes one complete header line, the empty line ends the header and starts the Updater.
+ */
+PRIVATE void OU_OnHeaderLine(void) {
+  static const char contentLength[] = "Content-Length:";
+
+  if (0 == OU_HttpStatus) {
+    /* Status line "HTTP/1.x 200 OK" */
+    const char* code = strchr(OU_Line, ' ');
+    OU_HttpStatus = (NULL != code) ? (UW)strtoul(code + 1, NULL, 10) : 1;
+    return;
+  }
+  if (0 == strncasecmp(OU_Line, contentLength, sizeof(contentLength) - 1)) {
+    OU_Size = strtoul(&OU_Line[sizeof(contentLength) - 1], NULL, 10);
+    return;
+  }
+  if ('\0' != OU_Line[0]) {
+    return; /* Other header */
+  }
+
+  /* End of the header */
+  if (200 != OU_HttpStatus) {
+    OU_Fail("HTTP status");
+  } else if ((0 == OU_Size) || (OU_Size > ESP.getFreeSketchSpace())) {
+    OU_Fail("image size");
+  } else if (!Update.begin(OU_Size)) {
+    OU_Fail("flash begin");
+  } else {
+    OU_UpdateStarted = true;
+    if (('\0' != OU_Md5[0]) && !Update.setMD5(OU_Md5)) {
+      OU_Fail("MD5");
+      return;
+    }
+    OU_State = OTA_STATE_DOWNLOAD;
+    CONSOLE_INFO("OTA: downloading %lu bytes", (unsigned long)OU_Size);
+  }
+}
+
+/**
+ * @brief Receives the response header (only the bytes already received, at most one chunk).
+ */
+PRIVATE void OU_ReadHeader(void) {
+  for (UW i = 0; (i < OTA_CHUNK_SIZE) && (OTA_STATE_HEADER == OU_State) && (OU_Client.available() > 0); i++) {
+    char c = (char)OU_Client.read();
+    OU_LastData = millis();
+    if ('\r' == c) {
+      continue;
+    }
+    if ('\n' == c) {
+      OU_Line[OU_LineLen] = '\0';
+      OU_LineLen = 0;
+      OU_OnHeaderLine();
+    } else if (OU_LineLen < (OTA_LINE_LEN - 1)) {
+      OU_Line[OU_LineLen++] = c; /* Longer lines are cut (not needed headers) */
+    }
+  }
+}
+
+/**
+ * @brief Writes the next chunk of the image to flash, finishes the update after the last one.
+ * Held back while the sensor fetch is due, so a sector erase does not delay it.
+ */
+PRIVATE void OU_Download(void) {
+  if (!IsBusFree()) {
+    return;
+  }
+
+  uint32_t remaining = OU_Size - OU_Written;
+  int available = OU_Client.available();
+  if (available > 0) {
+    size_t len = (size_t)available;
+    if (len > OTA_CHUNK_SIZE) {
+      len = OTA_CHUNK_SIZE;
+    }
+    if (len > remaining) {
+      len = remaining;
+    }
+    int got = OU_Client.read(OU_Buffer, len);
+    if (got <= 0) {
+      return;
+    }
+    if (Update.write(OU_Buffer, (size_t)got) != (size_t)got) {
+      OU_Fail("flash write");
+      return;
+    }
+    OU_Written += (uint32_t)got;
+    OU_LastData = millis();
+  }
+
+  if (OU_Written < OU_Size) {
+    if (!OU_Client.connected() && (0 == OU_Client.available())) {
+      OU_Fail("connection closed");
+    }
+    return;
+  }
+
+  OU_Client.stop();
+  OU_UpdateStarted = false;
+  if (!Update.end()) {
+    OU_Fail("image check (MD5)");
+    return;
+  }
+  OU_State = OTA_STATE_DONE;
+  CONSOLE_INFO("OTA: image complete, reboot needed");
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Requests a firmware update (the download starts on the next Run_Ota() call).
+ * A finished or failed update can be followed by a new request. A given 
+ * MD5 must have exactly OTA_MD5_LEN hex digits (an image is never flashed 
+ * unchecked because of a malformed MD5). An image with the MD5 of the 
+ * running firmware is rejected, so a request left (retained) on the broker 
+ * does not flash the same image after every boot.
+ * @param url The image URL ("http://a.b.c.d[:port]/path", IP address of the server).
+ * @param md5 The expected MD5 of the image (hex string), NULL or empty = not checked.
+ * @return bool True if the request was accepted (valid URL, no update running).
+ */
+bool StartOta(const char* url, const char* md5) {
+  if (IsOtaRunning() || (OTA_STATE_DONE == OU_State)) {
+    return false;
+  }
+  if (!OU_ParseUrl(url)) {
+    OU_Error = "URL";
+    OU_State = OTA_STATE_ERROR;
+    return false;
+  }
+  OU_Md5[0] = '\0';
+  if ((NULL != md5) && ('\0' != md5[0])) {
+    if (!OU_IsMd5Valid(md5)) {
+      OU_Error = "MD5";
+      OU_State = OTA_STATE_ERROR;
+      return false;
+    }
+    strcpy(OU_Md5, md5);
+  }
+  if (('\0' != OU_Md5[0]) && (0 == strcasecmp(OU_Md5, ESP.getSketchMD5().c_str()))) {
+    OU_Error = "same image";
+    OU_State = OTA_STATE_ERROR;
+    return false;
+  }
+  OU_Error = "";
+  OU_State = OTA_STATE_CONNECT;
+  return true;
+}
+
+/**
+ * @brief Runs one step of the update (call every OTA_PERIOD).
+ * One step handles at most OTA_CHUNK_SIZE bytes of the response.
+ */
+void Run_Ota() {
+  switch (OU_State) {
+    case OTA_STATE_CONNECT:
+      OU_Connect();
+      return;
+    case OTA_STATE_HEADER:
+      OU_ReadHeader();
+      break;
+    case OTA_STATE_DOWNLOAD:
+      OU_Download();
+      break;
+    default:
+      return;
+  }
+  if (IsOtaRunning() && ((millis() - OU_LastData) >= OTA_DATA_TIMEOUT)) {
+    OU_Fail("timeout");
+  }
+}
+
+/**
+ * @brief Checks if an update is being downloaded.
+ * @return bool True from StartOta() until the image is complete or the update failed.
+ */
+bool IsOtaRunning() {
+  return (OTA_STATE_CONNECT == OU_State) || (OTA_STATE_HEADER == OU_State) || (OTA_STATE_DOWNLOAD == OU_State);
+}
+
+/**
+ * @brief Gets the state of the update.
+ * @return UB The state (OTA_STATE_xxx).
+ */
+UB GetOtaState() {
+  return OU_State;
+}
+
+/**
+ * @brief Gets the number of the image bytes written to flash.
+ * @return uint32_t The written bytes.
+ */
+uint32_t GetOtaProgress() {
+  return OU_Written;
+}
+
+/**
+ * @brief Gets the image size (HTTP Content-Length).
+ * @return uint32_t The image size [bytes], 0 until the header is received.
+ */
+uint32_t GetOtaSize() {
+  return OU_Size;
+}
+
+/**
+ * @brief Gets the reason of the failed update.
+ * @return const char* The error text ("" if no error).
+ */
+const char* GetOtaError() {
+  return OU_Error;
+}
+#endif /* OTA_ACTIVE */
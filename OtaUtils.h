@@ -0,0 +1,97 @@
+/**
+ * @file OtaUtils.h
+ * @brief Header file for the non-blocking HTTP firmware update.
+ * The firmware image is downloaded from a plain HTTP URL (requested over
+ * MQTT) in small chunks, one chunk per Run_Ota() call, so the scheduler
+ * keeps sampling during the download. The chunks are held back while the
+ * sensor fetch is due (a flash sector erase blocks the CPU for tens of
+ * milliseconds). The new image becomes active after the reboot done by
+ * the caller.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef OTA_UTILS_H
+#define OTA_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <stdint.h>
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+#define OTA_ACTIVE 1 /* 1-Enable / 0-Disable the firmware update over HTTP (continuous mode only) */
+
+#define OTA_URL_LEN 128 /* Max. length of the image URL "http://a.b.c.d[:port]/path" */
+#define OTA_MD5_LEN 32 /* MD5 of the image (hex string) */
+#define OTA_LINE_LEN 128 /* Longest parsed HTTP header line (longer ones are skipped) */
+#define OTA_CHUNK_SIZE 1024 /* Max. bytes written to flash per Run_Ota() call */
+#define OTA_PERIOD 20 /* Period of the Run_Ota() calls [ms] (max. ~50 kB/s) */
+#define OTA_CONNECT_TIMEOUT 300 /* TCP connect timeout (blocks the scheduler, server in the LAN) [ms] */
+#define OTA_DATA_TIMEOUT 10000 /* Max. time without received data [ms] */
+#define OTA_REPORT_STEP 65536 /* Progress report step [bytes] */
+
+/**
+ * @brief States of the update (GetOtaState()).
+ */
+#define OTA_STATE_IDLE 0 /* No update running */
+#define OTA_STATE_CONNECT 1 /* Request accepted, connection on the next call */
+#define OTA_STATE_HEADER 2 /* Receiving the HTTP response header */
+#define OTA_STATE_DOWNLOAD 3 /* Writing the image to flash */
+#define OTA_STATE_DONE 4 /* Image complete and verified, reboot needed */
+#define OTA_STATE_ERROR 5 /* Update failed (GetOtaError()), the running firmware stays */
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Requests a firmware update (the download starts on the next Run_Ota() call).
+ * @param url The image URL ("http://a.b.c.d[:port]/path", IP address of the server).
+ * @param md5 The expected MD5 of the image (hex string), NULL or empty = not checked.
+ * @return bool True if the request was accepted (valid URL and MD5, no update running, not the running image).
+ */
+bool StartOta(const char* url, const char* md5);
+
+/**
+ * @brief Runs one step of the update (call every OTA_PERIOD).
+ */
+void Run_Ota(void);
+
+/**
+ * @brief Checks if an update is being downloaded.
+ * @return bool True from StartOta() until the image is complete or the update failed.
+ */
+bool IsOtaRunning(void);
+
+/**
+ * @brief Gets the state of the update.
+ * @return UB The state (OTA_STATE_xxx).
+ */
+UB GetOtaState(void);
+
+/**
+ * @brief Gets the number of the image bytes written to flash.
+ * @return uint32_t The written bytes.
+ */
+uint32_t GetOtaProgress(void);
+
+/**
+ * @brief Gets the image size (HTTP Content-Length).
+ * @return uint32_t The image size [bytes], 0 until the header is received.
+ */
+uint32_t GetOtaSize(void);
+
+/**
+ * @brief Gets the reason of the failed update.
+ * @return const char* The error text ("" if no error).
+ */
+const char* GetOtaError(void);
+
+#endif // OTA_UTILS_H
@@ -0,0 +1,114 @@
+/**
+ * @file ProfileUtils.cpp
+ * @brief Implementation file for the on-device timing instrumentation of the hot path.
+ * This file provides the definitions (logic) for the functions 
+ * declared in ProfileUtils.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h> /* ESP.getCpuFreqMHz() */
+#include <string.h>
+#include "Global.h"
+#include "ProfileUtils.h"
+
+#if (PROF_ACTIVE == 1)
+
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Span names (index = PROF_SPAN_x).
+ */
+PRIVATE const char* const PU_SpanNames[PROF_SPAN_COUNT] = {
+  "sensor", "filter", "display", "flush", "serial", "publish", "ota"
+};
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Statistics of all spans in the current window.
+ */
+PRIVATE ProfStats PU_Stats[PROF_SPAN_COUNT];
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Adds one measured span to the statistics.
+ * The unsigned difference is correct over the counter overflow 
+ * (spans shorter than 2^32 cycles, ~53 s at 80 MHz).
+ * @param span The span ID (PROF_SPAN_x).
+ * @param start The cycle counter at the span start (StartProfileSpan()).
+ */
+void StopProfileSpan(UB span, uint32_t start) {
+  uint32_t cycles = ESP.getCycleCount() - start;
+
+  if (span >= PROF_SPAN_COUNT) {
+    return;
+  }
+
+  ProfStats* stats = &PU_Stats[span];
+  if ((0 == stats->count) || (cycles < stats->minCycles)) {
+    stats->minCycles = cycles;
+  }
+  if (cycles > stats->maxCycles) {
+    stats->maxCycles = cycles;
+  }
+  stats->count++;
+  stats->sumCycles += cycles;
+
+  /* Decade histogram: <100 us, <1 ms, <10 ms, >=10 ms */
+  uint32_t limit = PROF_HIST_FIRST_US * ESP.getCpuFreqMHz();
+  UB bucket = 0;
+  while ((bucket < (PROF_HIST_COUNT - 1)) && (cycles >= limit)) {
+    limit *= 10;
+    bucket++;
+  }
+  stats->hist[bucket]++;
+}
+
+/**
+ * @brief Gets the statistics of one span.
+ * @param span The span ID (PROF_SPAN_x).
+ * @return const ProfStats* Read-only pointer to the statistics, nullptr for an unknown span.
+ */
+const ProfStats* GetProfileStats(UB span) {
+  return (span < PROF_SPAN_COUNT) ? &PU_Stats[span] : nullptr;
+}
+
+/**
+ * @brief Gets the name of one span (used as the JSON key).
+ * @param span The span ID (PROF_SPAN_x).
+ * @return const char* The span name.
+ */
+const char* GetProfileSpanName(UB span) {
+  return (span < PROF_SPAN_COUNT) ? PU_SpanNames[span] : "";
+}
+
+/**
+ * @brief Converts CPU cycles to microseconds.
+ * @param cycles The number of CPU cycles.
+ * @return uint32_t The duration [us].
+ */
+uint32_t ProfileCyclesToUs(uint64_t cycles) {
+  return (uint32_t)(cycles / ESP.getCpuFreqMHz());
+}
+
+/**
+ * @brief Clears the statistics of all spans (starts a new window).
+ */
+void ResetProfile() {
+  memset(PU_Stats, 0, sizeof(PU_Stats));
+}
+
+#endif /* PROF_ACTIVE */
@@ -0,0 +1,123 @@
+/**
+ * @file ProfileUtils.h
+ * @brief Header file for the on-device timing instrumentation of the hot path.
+ * The duration of the instrumented spans (sensor read, filter, display, 
+ * serial output, publish) is measured with the CPU cycle counter and kept 
+ * as count/min/max/mean and a coarse decade histogram in a fixed-size 
+ * table. The statistics are reported on the status topic (PublishProfile()).
+ * With PROF_ACTIVE = 0 the spans compile to nothing.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef PROFILE_UTILS_H
+#define PROFILE_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h> /* ESP.getCycleCount() */
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+#define PROF_ACTIVE 1 /* 1-Enable / 0-Disable the timing instrumentation */
+#define PROF_REPORT_PERIOD 300000UL /* Period of the timing report (statistics window) [ms] */
+
+/**
+ * @brief Instrumented spans.
+ */
+#define PROF_SPAN_SENSOR 0  /* Sensor result fetch (I2C) */
+#define PROF_SPAN_FILTER 1  /* Trend, history and smoothing */
+#define PROF_SPAN_DISPLAY 2 /* PrintToDisplay() (rendering into the frame buffer) */
+#define PROF_SPAN_FLUSH 3   /* FlushDisplay() with data sent (I2C) */
+#define PROF_SPAN_SERIAL 4  /* PrintToSerial() */
+#define PROF_SPAN_PUBLISH 5 /* PublishData() / PublishBatch() */
+#define PROF_SPAN_OTA 6     /* Run_Ota() (firmware chunk written to flash) */
+#define PROF_SPAN_COUNT 7
+
+/**
+ * @brief Histogram buckets (decades): <100 us, <1 ms, <10 ms, >=10 ms.
+ */
+#define PROF_HIST_COUNT 4
+#define PROF_HIST_FIRST_US 100 /* Upper limit of the first bucket [us] */
+
+// --------------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Statistics of one span in the current window (durations in CPU cycles).
+ */
+typedef struct {
+  uint32_t count;
+  uint32_t minCycles;
+  uint32_t maxCycles;
+  uint64_t sumCycles;
+  uint32_t hist[PROF_HIST_COUNT];
+} ProfStats;
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+#if (PROF_ACTIVE == 1)
+/**
+ * @brief Adds one measured span to the statistics.
+ * @param span The span ID (PROF_SPAN_x).
+ * @param start The cycle counter at the span start (StartProfileSpan()).
+ */
+void StopProfileSpan(UB span, uint32_t start);
+
+/**
+ * @brief Gets the statistics of one span.
+ * @param span The span ID (PROF_SPAN_x).
+ * @return const ProfStats* Read-only pointer to the statistics, nullptr for an unknown span.
+ */
+const ProfStats* GetProfileStats(UB span);
+
+/**
+ * @brief Gets the name of one span (used as the JSON key).
+ * @param span The span ID (PROF_SPAN_x).
+ * @return const char* The span name.
+ */
+const char* GetProfileSpanName(UB span);
+
+/**
+ * @brief Converts CPU cycles to microseconds.
+ * @param cycles The number of CPU cycles.
+ * @return uint32_t The duration [us].
+ */
+uint32_t ProfileCyclesToUs(uint64_t cycles);
+
+/**
+ * @brief Clears the statistics of all spans (starts a new window).
+ */
+void ResetProfile(void);
+#endif /* PROF_ACTIVE */
+
+// --------------------------------------------------------------------------
+// PUBLIC INLINE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Marks the start of a span.
+ * @return uint32_t The cycle counter (0 without PROF_ACTIVE).
+ */
+inline uint32_t StartProfileSpan(void) {
+#if (PROF_ACTIVE == 1)
+  return ESP.getCycleCount();
+#else
+  return 0;
+#endif /* PROF_ACTIVE */
+}
+
+#if (PROF_ACTIVE == 0)
+inline void StopProfileSpan(UB, uint32_t) {}
+#endif /* PROF_ACTIVE */
+
+#endif // PROFILE_UTILS_H
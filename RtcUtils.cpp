@@ -0,0 +1,113 @@
+/**
+ * @file RtcUtils.cpp
+ * @brief Implementation file for the CRC protected records in the RTC user memory.
+ * This file provides the definitions (logic) for the functions 
+ * declared in RtcUtils.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h> /* ESP.rtcUserMemoryRead/Write() */
+#include <string.h>
+#include "Global.h"
+#include "RtcUtils.h"
+
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+/* Number of the 4-byte blocks in the working buffer (CRC + data) */
+#define RTC_RECORD_BLOCKS (1 + (RTC_RECORD_MAX_LEN / 4))
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Calculates the record length rounded up to whole 4-byte blocks.
+ * @param len Record length in bytes.
+ * @return size_t Number of bytes occupied in the RTC memory (CRC block included).
+ */
+PRIVATE size_t RU_StoredSize(size_t len) {
+  return sizeof(uint32_t) + (((len + 3) / 4) * 4);
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Calculates the CRC32 checksum (polynomial 0xEDB88320, reflected).
+ * @param data Pointer to the checked data.
+ * @param len Number of the checked bytes.
+ * @return uint32_t The calculated checksum.
+ */
+uint32_t CalcCrc32(const void* data, size_t len) {
+  const UB* bytes = (const UB*)data;
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= bytes[i];
+    for (UB bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+    }
+  }
+  return ~crc;
+}
+
+/**
+ * @brief Writes a record together with its CRC32 to the RTC user memory.
+ * @param offset Record offset in 4-byte blocks (RTC_OFFSET_xxx).
+ * @param data Pointer to the record data.
+ * @param len Record length in bytes (max. RTC_RECORD_MAX_LEN).
+ * @return bool True on success.
+ */
+bool WriteRtcRecord(UB offset, const void* data, size_t len) {
+  uint32_t buffer[RTC_RECORD_BLOCKS] = {0};
+
+  if (len > RTC_RECORD_MAX_LEN) {
+    return false;
+  }
+  memcpy(&buffer[1], data, len);
+  buffer[0] = CalcCrc32(&buffer[1], len);
+
+  return ESP.rtcUserMemoryWrite(offset, buffer, RU_StoredSize(len));
+}
+
+/**
+ * @brief Reads a record from the RTC user memory and checks its CRC32.
+ * @param offset Record offset in 4-byte blocks (RTC_OFFSET_xxx).
+ * @param data Output buffer for the record data.
+ * @param len Record length in bytes (max. RTC_RECORD_MAX_LEN).
+ * @return bool True if the record is valid, false otherwise (data are not changed).
+ */
+bool ReadRtcRecord(UB offset, void* data, size_t len) {
+  uint32_t buffer[RTC_RECORD_BLOCKS];
+
+  if (len > RTC_RECORD_MAX_LEN) {
+    return false;
+  }
+  if (!ESP.rtcUserMemoryRead(offset, buffer, RU_StoredSize(len))) {
+    return false;
+  }
+  if ((0 == buffer[0]) || (buffer[0] != CalcCrc32(&buffer[1], len))) {
+    return false; /* Power-on garbage or an old layout */
+  }
+
+  memcpy(data, &buffer[1], len);
+  return true;
+}
+
+/**
+ * @brief Invalidates a record in the RTC user memory.
+ * Only the CRC block is overwritten, a zero CRC is always rejected by ReadRtcRecord().
+ * @param offset Record offset in 4-byte blocks (RTC_OFFSET_xxx).
+ */
+void ClearRtcRecord(UB offset) {
+  uint32_t crc = 0;
+  ESP.rtcUserMemoryWrite(offset, &crc, sizeof(crc));
+}
@@ -0,0 +1,79 @@
+/**
+ * @file RtcUtils.h
+ * @brief Header file for the CRC protected records in the RTC user memory.
+ * The RTC user memory (512 bytes) survives reset and deep sleep, but not 
+ * a power cycle. Each record is stored with a CRC32, so an invalid 
+ * (e.g. after power-on) record is detected and rejected.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef RTC_UTILS_H
+#define RTC_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Record offsets in the RTC user memory (in 4-byte blocks, 0..127).
+ * The first 128 bytes (blocks 0..31) are overwritten by the OTA update (eboot), 
+ * so the records start at block 32. Each record uses 1 block for CRC + data blocks.
+ */
+#define RTC_OFFSET_WIFI 32 /* WiFi fast reconnect data (4 blocks) */
+#define RTC_OFFSET_DATAUTILS 36 /* DataUtils state snapshot (max. 17 blocks) */
+#define RTC_OFFSET_LOGCLOCK 53 /* Device clock of the log (2 blocks) */
+#define RTC_OFFSET_OUTLIERS 55 /* Outlier stage windows (max. 17 blocks) */
+
+/**
+ * @brief Maximal record length [bytes].
+ */
+#define RTC_RECORD_MAX_LEN 64
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Calculates the CRC32 checksum (polynomial 0xEDB88320, reflected).
+ * Also used for the other persisted records (e.g. the flash config).
+ * @param data Pointer to the checked data.
+ * @param len Number of the checked bytes.
+ * @return uint32_t The calculated checksum.
+ */
+uint32_t CalcCrc32(const void* data, size_t len);
+
+/**
+ * @brief Writes a record together with its CRC32 to the RTC user memory.
+ * @param offset Record offset in 4-byte blocks (RTC_OFFSET_xxx).
+ * @param data Pointer to the record data.
+ * @param len Record length in bytes (max. RTC_RECORD_MAX_LEN).
+ * @return bool True on success.
+ */
+bool WriteRtcRecord(UB offset, const void* data, size_t len);
+
+/**
+ * @brief Reads a record from the RTC user memory and checks its CRC32.
+ * @param offset Record offset in 4-byte blocks (RTC_OFFSET_xxx).
+ * @param data Output buffer for the record data.
+ * @param len Record length in bytes (max. RTC_RECORD_MAX_LEN).
+ * @return bool True if the record is valid, false otherwise (data are not changed).
+ */
+bool ReadRtcRecord(UB offset, void* data, size_t len);
+
+/**
+ * @brief Invalidates a record in the RTC user memory.
+ * @param offset Record offset in 4-byte blocks (RTC_OFFSET_xxx).
+ */
+void ClearRtcRecord(UB offset);
+
+#endif // RTC_UTILS_H
@@ -0,0 +1,107 @@
+/**
+ * @file Scheduler.cpp
+ * @brief Implementation file for the cooperative millis()-based task scheduler.
+ * This file provides the definitions (logic) for the functions 
+ * declared in Scheduler.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Arduino.h> /* millis() */
+#include "Global.h"
+#include "Scheduler.h"
+
+// --------------------------------------------------------------------------
+// PRIVATE TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief One entry of the scheduler table.
+ */
+typedef struct {
+  SchedTaskFunc func;     /* Task function */
+  unsigned long period;   /* Task period [ms] */
+  unsigned long nextRun;  /* Time stamp of the next planned execution [ms] */
+} SchedTask;
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Table of the registered tasks (executed in order of registration).
+ */
+PRIVATE SchedTask SC_Tasks[SCHED_MAX_TASKS];
+
+/**
+ * @brief Number of the registered tasks in SC_Tasks.
+ */
+PRIVATE UB SC_TaskCount = 0;
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Registers a new periodic task in the scheduler table.
+ * @param func The task function to be called.
+ * @param period The task period in milliseconds (SCHED_EVERY_PASS = every loop).
+ * @param offset Delay of the first execution in milliseconds from now.
+ * @return UB Task ID, or SCHED_INVALID_TASK when the table is full.
+ */
+UB AddSchedulerTask(SchedTaskFunc func, unsigned long period, unsigned long offset) {
+  if ((SC_TaskCount >= SCHED_MAX_TASKS) || (nullptr == func)) {
+    return SCHED_INVALID_TASK;
+  }
+
+  SC_Tasks[SC_TaskCount].func = func;
+  SC_Tasks[SC_TaskCount].period = period;
+  SC_Tasks[SC_TaskCount].nextRun = millis() + offset;
+
+  return SC_TaskCount++;
+}
+
+/**
+ * @brief Changes the period of an already registered task.
+ * The next execution is re-planned relative to the last one, so a task 
+ * can change its own period from inside its task function.
+ * @param taskId The task ID returned by AddSchedulerTask().
+ * @param period The new task period in milliseconds.
+ */
+void SetSchedulerTaskPeriod(UB taskId, unsigned long period) {
+  if (taskId < SC_TaskCount) {
+    SC_Tasks[taskId].nextRun += period - SC_Tasks[taskId].period;
+    SC_Tasks[taskId].period = period;
+  }
+}
+
+/**
+ * @brief Runs all tasks which are due.
+ * The next execution time is advanced by exactly one period (not from 'now'), 
+ * so the time spent inside the tasks does not cause any drift. If a task 
+ * is late by more than a full period, the missed executions are skipped.
+ */
+void Run_Scheduler() {
+  for (UB i = 0; i < SC_TaskCount; i++) {
+    SchedTask* task = &SC_Tasks[i];
+    unsigned long now = millis();
+
+    /* Signed difference handles the millis() overflow (~49 days) */
+    if ((long)(now - task->nextRun) < 0) {
+      continue; /* Not due yet */
+    }
+
+    task->nextRun += task->period;
+    if ((long)(now - task->nextRun) >= 0) {
+      /* Task is late by more than one period, resynchronize */
+      task->nextRun = now + task->period;
+    }
+
+    task->func();
+  }
+}
@@ -0,0 +1,76 @@
+/**
+ * @file Scheduler.h
+ * @brief Header file for the cooperative millis()-based task scheduler.
+ * The scheduler keeps a small static table of periodic tasks and runs 
+ * every task whose period has elapsed. Tasks must never block, so the 
+ * main loop returns immediately and the network stack is serviced 
+ * on every pass.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Maximum number of tasks the scheduler table can hold.
+ * The sketch registers max. 16 tasks with all features (checked by a static_assert there).
+ */
+#define SCHED_MAX_TASKS 20
+
+/**
+ * @brief Period value for tasks executed on every scheduler pass.
+ */
+#define SCHED_EVERY_PASS 0
+
+/**
+ * @brief Task ID returned when the task could not be registered.
+ */
+#define SCHED_INVALID_TASK 0xFF
+
+// --------------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Task function type. Task functions must return quickly (no delay()).
+ */
+typedef void (*SchedTaskFunc)(void);
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Registers a new periodic task in the scheduler table.
+ * @param func The task function to be called.
+ * @param period The task period in milliseconds (SCHED_EVERY_PASS = every loop).
+ * @param offset Delay of the first execution in milliseconds from now.
+ * @return UB Task ID, or SCHED_INVALID_TASK when the table is full.
+ */
+UB AddSchedulerTask(SchedTaskFunc func, unsigned long period, unsigned long offset);
+
+/**
+ * @brief Changes the period of an already registered task.
+ * @param taskId The task ID returned by AddSchedulerTask().
+ * @param period The new task period in milliseconds.
+ */
+void SetSchedulerTaskPeriod(UB taskId, unsigned long period);
+
+/**
+ * @brief Runs all tasks which are due. Must be called from loop().
+ */
+void Run_Scheduler(void);
+
+#endif // SCHEDULER_H
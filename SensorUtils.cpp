@@ -0,0 +1,349 @@
+/**
+ * @file SensorUtils.cpp
+ * @brief Implementation file for the SHT31 sensor sampling layer.
+ * This file provides the definitions (logic) for the functions 
+ * declared in SensorUtils.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <Wire.h> /* TWI/I2C library for Arduino & Wiring */
+#include "Adafruit_SHT31.h" /* SHT31 - Adafruit SHT31 Library */
+#include "Global.h"
+#include "SensorUtils.h"
+#include "BusUtils.h" /* Bus reservation of the result fetch */
+
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+/* Single-shot measurement, high repeatability, clock stretching disabled */
+#define SHT31_CMD_MEAS_MSB 0x24
+#define SHT31_CMD_MEAS_LSB 0x00
+
+/* Measurement response: T(MSB, LSB, CRC), RH(MSB, LSB, CRC) */
+#define SHT31_DATA_LEN 6
+
+/* Status and control commands */
+#define SHT31_CMD_STATUS 0xF32D /* Read status register */
+#define SHT31_CMD_CLEAR 0x3041 /* Clear status register */
+#define SHT31_CMD_RESET 0x30A2 /* Soft reset */
+#define SHT31_CMD_HEATER_OFF 0x3066 /* Heater disable */
+
+/* Status response: status(MSB, LSB, CRC) */
+#define SHT31_STATUS_LEN 3
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+static_assert((SENSOR_COUNT > 0) && (SENSOR_COUNT <= SENSOR_MAX_COUNT), "SENSOR_COUNT out of range");
+
+/**
+ * @brief Instances for the SHT31 sensors.
+ */
+PRIVATE Adafruit_SHT31 SU_Sht30[SENSOR_COUNT];
+
+/**
+ * @brief I2C addresses of the sensors (used by the split start/fetch measurement).
+ */
+PRIVATE UB SU_Address[SENSOR_COUNT];
+
+/**
+ * @brief Sensor index and I2C address of the pending split measurement.
+ */
+PRIVATE UB SU_MeasSensor = 0;
+PRIVATE UB SU_MeasAddress = 0;
+
+/**
+ * @brief Consecutive failed measurements of each sensor.
+ */
+PRIVATE UB SU_ErrorCount[SENSOR_COUNT];
+
+/**
+ * @brief Soft reset sent to the sensor, its reset flag is expected (not counted).
+ */
+PRIVATE bool SU_OwnReset[SENSOR_COUNT];
+
+/**
+ * @brief Fault counters (all sensors).
+ */
+PRIVATE SensorFaults SU_Faults = {0, 0, 0, 0, 0, 0};
+
+/**
+ * @brief True if a measurement was started and not yet collected.
+ */
+PRIVATE bool SU_MeasPending = false;
+
+/**
+ * @brief Time stamp of the measurement start [ms].
+ */
+PRIVATE unsigned long SU_MeasStartTime = 0;
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Calculates the SHT31 CRC-8 checksum (polynomial 0x31, init 0xFF).
+ * @param data Pointer to the checked data.
+ * @param len Number of the checked bytes.
+ * @return UB The calculated checksum.
+ */
+PRIVATE UB SU_Crc8(const UB* data, UB len) {
+  UB crc = 0xFF;
+  for (UB i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (UB bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (UB)((crc << 1) ^ 0x31) : (UB)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief Sends one 16-bit command to a sensor.
+ * @param address The 7-bit I2C address.
+ * @param cmd The command.
+ * @return bool True if the command was acknowledged.
+ */
+PRIVATE bool SU_WriteCommand(UB address, UW cmd) {
+  Wire.beginTransmission(address);
+  Wire.write((UB)(cmd >> 8));
+  Wire.write((UB)(cmd & 0xFF));
+  return (0 == Wire.endTransmission());
+}
+
+/**
+ * @brief Counts the result of one measurement, a sensor failing SENSOR_RESET_ERRORS 
+ * times in a row is soft-reset (it is tried again by the next measurement).
+ * @param sensor The sensor (channel) index.
+ * @param ok The measurement result.
+ */
+PRIVATE void SU_CountResult(UB sensor, bool ok) {
+  if (ok) {
+    SU_ErrorCount[sensor] = 0;
+    return;
+  }
+  SU_Faults.readErrors++;
+  if (++SU_ErrorCount[sensor] >= SENSOR_RESET_ERRORS) {
+    SU_ErrorCount[sensor] = 0;
+    ResetSensor(sensor);
+  }
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Initializes one SHT31 sensor and checks the connection.
+ * A failed init counts as a failed measurement and the error count is kept 
+ * over repeated calls, so the soft reset policy (SU_CountResult()) also 
+ * covers the init retries of the caller.
+ * @param sensor The sensor (channel) index (0..SENSOR_COUNT-1).
+ * @param address The 7-bit I2C address of the sensor (0x44 or 0x45).
+ * @return bool True if the sensor responded, false otherwise.
+ */
+bool Init_Sensor(UB sensor, UB address) {
+  if (sensor >= SENSOR_COUNT) {
+    return false;
+  }
+  SU_Address[sensor] = address;
+  SU_OwnReset[sensor] = false;
+  SU_MeasPending = false;
+  if (!SU_Sht30[sensor].begin(address)) {
+    SU_CountResult(sensor, false);
+    return false;
+  }
+  /* The reset flag of the power-on, so only a later reset is reported */
+  SU_WriteCommand(address, SHT31_CMD_CLEAR);
+  return true;
+}
+
+/**
+ * @brief Gets the I2C address of one sensor.
+ * @param sensor The sensor (channel) index.
+ * @return UB The 7-bit I2C address (0 if not initialized).
+ */
+UB GetSensorAddress(UB sensor) {
+  return (sensor < SENSOR_COUNT) ? SU_Address[sensor] : 0;
+}
+
+/**
+ * @brief Reads temperature and humidity from one single-shot measurement.
+ * The separate readTemperature()/readHumidity() calls would each start 
+ * their own measurement (with ~20 ms conversion wait) and throw half of 
+ * the data away. readBoth() measures once and returns both values, 
+ * which halves the I2C bus time and the sensor self-heating.
+ * @param sensor The sensor (channel) index.
+ * @param t Output for the measured temperature [C].
+ * @param h Output for the measured relative humidity [%].
+ * @return bool True if the data are valid (CRC OK, not NaN), false otherwise.
+ */
+bool ReadSensor(UB sensor, float* t, float* h) {
+  if (sensor >= SENSOR_COUNT) {
+    return false;
+  }
+  bool ok = SU_Sht30[sensor].readBoth(t, h) && !(isnan(*t) || isnan(*h)); /* I2C or CRC error */
+  SU_CountResult(sensor, ok);
+  return ok;
+}
+
+/**
+ * @brief Starts a single-shot measurement without waiting for the result.
+ * The clock stretching is disabled, so the sensor simply does not acknowledge 
+ * the read request until the conversion is finished and the bus stays free.
+ * A new start replaces a pending measurement (its result is not collected).
+ * @param sensor The sensor (channel) index.
+ * @return bool True if the command was acknowledged by the sensor.
+ */
+bool StartSensorMeasurement(UB sensor) {
+  if (sensor >= SENSOR_COUNT) {
+    return false;
+  }
+  SU_MeasSensor = sensor;
+  SU_MeasAddress = SU_Address[sensor];
+  Wire.beginTransmission(SU_MeasAddress);
+  Wire.write((UB)SHT31_CMD_MEAS_MSB);
+  Wire.write((UB)SHT31_CMD_MEAS_LSB);
+  SU_MeasPending = (0 == Wire.endTransmission());
+  SU_MeasStartTime = millis();
+  if (SU_MeasPending) {
+    /* The fetch has priority over the display transfers */
+    ReserveBus(SU_MeasStartTime + SHT31_CONVERSION_TIME);
+  } else {
+    SU_CountResult(sensor, false);
+  }
+  return SU_MeasPending;
+}
+
+/**
+ * @brief Checks if the started measurement is finished and can be collected.
+ * @return bool True if a measurement is pending and its conversion time elapsed.
+ */
+bool IsSensorMeasurementReady() {
+  return SU_MeasPending && ((millis() - SU_MeasStartTime) >= SHT31_CONVERSION_TIME);
+}
+
+/**
+ * @brief Collects the result of the measurement started by StartSensorMeasurement().
+ * Conversion formulas (datasheet): T = -45 + 175 * raw / 65535, RH = 100 * raw / 65535.
+ * @param t Output for the measured temperature [C].
+ * @param h Output for the measured relative humidity [%].
+ * @return bool True if the data are valid (CRC OK), false otherwise.
+ */
+bool FetchSensorMeasurement(float* t, float* h) {
+  UB data[SHT31_DATA_LEN];
+
+  if (!SU_MeasPending) {
+    return false;
+  }
+  SU_MeasPending = false;
+  ReleaseBus();
+
+  if (Wire.requestFrom(SU_MeasAddress, (size_t)SHT31_DATA_LEN) != SHT31_DATA_LEN) {
+    SU_CountResult(SU_MeasSensor, false);
+    return false; /* Sensor did not respond (NACK) */
+  }
+  for (UB i = 0; i < SHT31_DATA_LEN; i++) {
+    data[i] = (UB)Wire.read();
+  }
+
+  if ((SU_Crc8(&data[0], 2) != data[2]) || (SU_Crc8(&data[3], 2) != data[5])) {
+    SU_CountResult(SU_MeasSensor, false);
+    return false; /* Corrupted data */
+  }
+  SU_CountResult(SU_MeasSensor, true);
+
+  unsigned int rawT = ((unsigned int)data[0] << 8) | data[1];
+  unsigned int rawH = ((unsigned int)data[3] << 8) | data[4];
+
+  *t = -45.0f + (175.0f * (float)rawT / 65535.0f);
+  *h = 100.0f * (float)rawH / 65535.0f;
+  return true;
+}
+
+/**
+ * @brief Sends the soft reset command to one sensor (the sensor is busy for SHT31_RESET_TIME).
+ * A pending measurement of the sensor is dropped.
+ * @param sensor The sensor (channel) index.
+ * @return bool True if the command was acknowledged by the sensor.
+ */
+bool ResetSensor(UB sensor) {
+  if (sensor >= SENSOR_COUNT) {
+    return false;
+  }
+  if (SU_MeasPending && (SU_MeasSensor == sensor)) {
+    SU_MeasPending = false;
+    ReleaseBus();
+  }
+  SU_Faults.softResets++;
+  SU_OwnReset[sensor] = true;
+  return SU_WriteCommand(SU_Address[sensor], SHT31_CMD_RESET);
+}
+
+/**
+ * @brief Reads and clears the status register of one sensor, handles the reported faults.
+ * A reset flag means the sensor lost its state (e.g. brown-out), a heater 
+ * left on (e.g. by a corrupted command) heats the sensor and biases the 
+ * temperature, so it is switched off. The status is cleared after each 
+ * read, so every flag is counted once.
+ * Must not be called while a measurement of the sensor is pending.
+ * @param sensor The sensor (channel) index.
+ * @param status Output for the status register (SHT31_STATUS_xxx), may be NULL.
+ * @return bool True if the status was read (CRC OK).
+ */
+bool CheckSensorStatus(UB sensor, UW* status) {
+  UB data[SHT31_STATUS_LEN];
+
+  if (sensor >= SENSOR_COUNT) {
+    return false;
+  }
+  UB address = SU_Address[sensor];
+  if (!SU_WriteCommand(address, SHT31_CMD_STATUS) ||
+      (Wire.requestFrom(address, (size_t)SHT31_STATUS_LEN) != SHT31_STATUS_LEN)) {
+    SU_Faults.statusErrors++;
+    return false;
+  }
+  for (UB i = 0; i < SHT31_STATUS_LEN; i++) {
+    data[i] = (UB)Wire.read();
+  }
+  if (SU_Crc8(&data[0], 2) != data[2]) {
+    SU_Faults.statusErrors++;
+    return false;
+  }
+
+  UW value = ((UW)data[0] << 8) | data[1];
+  if ((value & SHT31_STATUS_RESET) && !SU_OwnReset[sensor]) {
+    SU_Faults.resetDetects++;
+  }
+  SU_OwnReset[sensor] = false;
+  if (value & SHT31_STATUS_HEATER) {
+    SU_Faults.heaterOffs++;
+    SU_WriteCommand(address, SHT31_CMD_HEATER_OFF);
+  }
+  if (value & SHT31_STATUS_ALERT) {
+    SU_Faults.alerts++;
+  }
+  if (value & (SHT31_STATUS_RESET | SHT31_STATUS_ALERT)) {
+    SU_WriteCommand(address, SHT31_CMD_CLEAR);
+  }
+  if (NULL != status) {
+    *status = value;
+  }
+  return true;
+}
+
+/**
+ * @brief Gets the fault counters of all sensors.
+ * @return const SensorFaults* The counters (since the boot).
+ */
+const SensorFaults* GetSensorFaults() {
+  return &SU_Faults;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file SensorUtils.h
+ * @brief Header file for the SHT31 sensor sampling layer.
+ * This file contains function declarations for reading temperature and 
+ * humidity from the SHT31 sensor in a single I2C measurement transaction.
+ * The measurement can be also split to start and fetch phases, so the 
+ * CPU is not blocked during the sensor conversion time.
+ * Up to SENSOR_MAX_COUNT sensors (channels) are supported, only one 
+ * split measurement runs at a time (the caller goes round-robin).
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef SENSOR_UTILS_H
+#define SENSOR_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <stdint.h>
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Maximal conversion time of the high repeatability single-shot measurement [ms].
+ * Datasheet value is 15.5 ms, rounded up plus one millis() tick (the start 
+ * may fall at the end of a tick, 16 counted ticks can be only 15 ms).
+ */
+#define SHT31_CONVERSION_TIME 17
+
+/**
+ * @brief Maximal number of the sensors (the SHT31 has two selectable addresses).
+ */
+#define SENSOR_MAX_COUNT 2
+
+/**
+ * @brief Consecutive failed measurements (NACK, CRC) of one sensor before it is soft-reset.
+ */
+#define SENSOR_RESET_ERRORS 3
+
+/**
+ * @brief Time of the sensor soft reset [ms] (datasheet max. 1.5 ms, rounded up).
+ */
+#define SHT31_RESET_TIME 2
+
+/**
+ * @brief Bits of the SHT31 status register (see CheckSensorStatus()).
+ */
+#define SHT31_STATUS_ALERT 0x8000 /* At least one alert pending */
+#define SHT31_STATUS_HEATER 0x2000 /* Heater on */
+#define SHT31_STATUS_RH_ALERT 0x0800 /* Humidity tracking alert */
+#define SHT31_STATUS_T_ALERT 0x0400 /* Temperature tracking alert */
+#define SHT31_STATUS_RESET 0x0010 /* Reset detected (power-on, brown-out, soft reset) since the last clear */
+
+// --------------------------------------------------------------------------
+// TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Fault counters of the sensors (sum of all channels).
+ */
+typedef struct {
+  uint32_t readErrors;   /* Failed measurements (start NACK, fetch NACK, CRC) */
+  uint32_t softResets;   /* Soft resets after SENSOR_RESET_ERRORS consecutive errors */
+  uint32_t resetDetects; /* Unexpected sensor resets seen in the status (e.g. brown-out) */
+  uint32_t heaterOffs;   /* Heater found on and switched off */
+  uint32_t alerts;       /* Status checks with a pending alert */
+  uint32_t statusErrors; /* Failed status register reads */
+} SensorFaults;
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Initializes one SHT31 sensor and checks the connection.
+ * @param sensor The sensor (channel) index (0..SENSOR_COUNT-1).
+ * @param address The 7-bit I2C address of the sensor (0x44 or 0x45).
+ * @return bool True if the sensor responded, false otherwise.
+ */
+bool Init_Sensor(UB sensor, UB address);
+
+/**
+ * @brief Gets the I2C address of one sensor.
+ * @param sensor The sensor (channel) index.
+ * @return UB The 7-bit I2C address (0 if not initialized).
+ */
+UB GetSensorAddress(UB sensor);
+
+/**
+ * @brief Reads temperature and humidity from one single-shot measurement.
+ * @param sensor The sensor (channel) index.
+ * @param t Output for the measured temperature [C].
+ * @param h Output for the measured relative humidity [%].
+ * @return bool True if the data are valid (CRC OK, not NaN), false otherwise.
+ */
+bool ReadSensor(UB sensor, float* t, float* h);
+
+/**
+ * @brief Starts a single-shot measurement without waiting for the result.
+ * @param sensor The sensor (channel) index.
+ * @return bool True if the command was acknowledged by the sensor.
+ */
+bool StartSensorMeasurement(UB sensor);
+
+/**
+ * @brief Checks if the started measurement is finished and can be collected.
+ * @return bool True if a measurement is pending and its conversion time elapsed.
+ */
+bool IsSensorMeasurementReady(void);
+
+/**
+ * @brief Collects the result of the measurement started by StartSensorMeasurement().
+ * The result belongs to the sensor given to the last StartSensorMeasurement().
+ * @param t Output for the measured temperature [C].
+ * @param h Output for the measured relative humidity [%].
+ * @return bool True if the data are valid (CRC OK), false otherwise.
+ */
+bool FetchSensorMeasurement(float* t, float* h);
+
+/**
+ * @brief Sends the soft reset command to one sensor (the sensor is busy for SHT31_RESET_TIME).
+ * @param sensor The sensor (channel) index.
+ * @return bool True if the command was acknowledged by the sensor.
+ */
+bool ResetSensor(UB sensor);
+
+/**
+ * @brief Reads and clears the status register of one sensor, handles the reported faults.
+ * Must not be called while a measurement of the sensor is pending.
+ * @param sensor The sensor (channel) index.
+ * @param status Output for the status register (SHT31_STATUS_xxx), may be NULL.
+ * @return bool True if the status was read (CRC OK).
+ */
+bool CheckSensorStatus(UB sensor, UW* status);
+
+/**
+ * @brief Gets the fault counters of all sensors.
+ * @return const SensorFaults* The counters (since the boot).
+ */
+const SensorFaults* GetSensorFaults(void);
+
+#endif // SENSOR_UTILS_H
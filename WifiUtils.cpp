@@ -0,0 +1,283 @@
+/**
+ * @file WifiUtils.cpp
+ * @brief Implementation file for the non-blocking WiFi connection handling.
+ * This file provides the definitions (logic) for the functions 
+ * declared in WifiUtils.h.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <ESP8266WiFi.h> /* WiFi lib for ESP8266 */
+#include <string.h>
+#include "Global.h"
+#include "WifiUtils.h"
+#include "RtcUtils.h"
+#include "ConsoleUtils.h" /* Buffered serial log */
+
+#if (WIFI_ACTIVE == 1)
+// --------------------------------------------------------------------------
+// PRIVATE TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief States of the WiFi connection state machine.
+ */
+typedef enum {
+  WU_STATE_CONNECTING,  /* Attempt running, waiting for an event or timeout */
+  WU_STATE_CONNECTED,   /* Connected, IP address assigned */
+  WU_STATE_WAIT_RETRY   /* Attempt failed, waiting for the next retry */
+} WU_State;
+
+/**
+ * @brief Fast reconnect data of the last good connection (stored in RTC memory).
+ */
+typedef struct {
+  UB bssid[6];   /* MAC address of the access point */
+  UB channel;    /* WiFi channel of the access point */
+  UB reserved;   /* Padding */
+} WU_FastConnect;
+
+// --------------------------------------------------------------------------
+// PRIVATE DATA (Static Variables)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Delays of the fast retries [ms], one entry per retry of WIFI_RETRY_BUDGET.
+ */
+PRIVATE const unsigned long WU_RetryDelays[WIFI_RETRY_BUDGET] = {1000, 2000, 5000, 10000, 30000};
+
+/**
+ * @brief Handlers of the WiFi station events (must be kept alive).
+ */
+PRIVATE WiFiEventHandler WU_GotIpHandler;
+PRIVATE WiFiEventHandler WU_DisconnectedHandler;
+
+/**
+ * @brief Flags set by the event handlers, processed by Run_Wifi().
+ */
+PRIVATE volatile bool WU_EventGotIp = false;
+PRIVATE volatile bool WU_EventDisconnected = false;
+
+/**
+ * @brief Current state of the connection state machine.
+ */
+PRIVATE WU_State WU_CurrentState = WU_STATE_CONNECTING;
+
+/**
+ * @brief Time stamp of the last state change [ms].
+ */
+PRIVATE unsigned long WU_StateTime = 0;
+
+/**
+ * @brief Number of the failed attempts since the last successful connection.
+ */
+PRIVATE UB WU_RetryCount = 0;
+
+/**
+ * @brief Cached BSSID/channel of the last good connection.
+ */
+PRIVATE WU_FastConnect WU_Cache;
+
+/**
+ * @brief True if the next attempt uses the cached BSSID/channel (no scan).
+ */
+PRIVATE bool WU_UseCache = false;
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Switches the state machine to a new state.
+ * @param newState The new state.
+ */
+PRIVATE void WU_SetState(WU_State newState) {
+  WU_CurrentState = newState;
+  WU_StateTime = millis();
+}
+
+/**
+ * @brief Starts one connection attempt (returns immediately).
+ * With valid cached data the AP is joined directly on the known channel, 
+ * otherwise the full scan is done by the SDK.
+ */
+PRIVATE void WU_Begin() {
+  /* Events of the previous attempt must not end this one */
+  WU_EventGotIp = false;
+  WU_EventDisconnected = false;
+  if (WU_UseCache) {
+    CONSOLE_INFO("Connecting to %s (cached) ch:%u", WIFI_SSID, WU_Cache.channel);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD, WU_Cache.channel, WU_Cache.bssid);
+  } else {
+    CONSOLE_INFO("Connecting to %s", WIFI_SSID);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  }
+  WU_SetState(WU_STATE_CONNECTING);
+}
+
+/**
+ * @brief Handles a failed attempt and plans the next retry.
+ * A failed attempt with the cached data is repeated immediately with the full 
+ * scan (the AP may have changed the channel) and it is not counted as a retry.
+ * The counter saturates just above the budget (= slow retries).
+ */
+PRIVATE void WU_Failed() {
+  if (WU_UseCache) {
+    WU_UseCache = false;
+    ClearRtcRecord(RTC_OFFSET_WIFI);
+    WU_Begin();
+    return;
+  }
+  if (WU_RetryCount <= WIFI_RETRY_BUDGET) {
+    WU_RetryCount++;
+  }
+  WU_SetState(WU_STATE_WAIT_RETRY);
+}
+
+/**
+ * @brief Stores the BSSID/channel of the current connection to the RTC memory.
+ * The RTC memory is written only if the data changed.
+ */
+PRIVATE void WU_SaveCache() {
+  const UB* bssid = WiFi.BSSID();
+  UB channel = (UB)WiFi.channel();
+
+  if (WU_UseCache && (channel == WU_Cache.channel) && (0 == memcmp(bssid, WU_Cache.bssid, sizeof(WU_Cache.bssid)))) {
+    return; /* Cache is up to date */
+  }
+  memcpy(WU_Cache.bssid, bssid, sizeof(WU_Cache.bssid));
+  WU_Cache.channel = channel;
+  WU_Cache.reserved = 0;
+  WriteRtcRecord(RTC_OFFSET_WIFI, &WU_Cache, sizeof(WU_Cache));
+  WU_UseCache = true;
+}
+
+/**
+ * @brief Gets the delay before the next retry from the retry schedule.
+ * @return unsigned long The retry delay [ms].
+ */
+PRIVATE unsigned long WU_GetRetryDelay() {
+  if ((0 == WU_RetryCount) || (WU_RetryCount > WIFI_RETRY_BUDGET)) {
+    /* Budget of the fast retries is used up */
+    return WIFI_RETRY_SLOW;
+  }
+  return WU_RetryDelays[WU_RetryCount - 1];
+}
+
+/**
+ * @brief Prints the connection details to the Serial Monitor.
+ */
+PRIVATE void WU_PrintConnected() {
+  CONSOLE_INFO("WiFi connected to AP: %s, IP address: %s, Signal: %d dBm, Mac: %s",
+               WIFI_SSID, WiFi.localIP().toString().c_str(), (int)WiFi.RSSI(), WiFi.macAddress().c_str());
+}
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Configures the WiFi station, registers the event handlers and starts 
+ * the first connection attempt. Returns immediately.
+ * The SDK auto-reconnect is disabled, the retries are planned by Run_Wifi().
+ * The cached BSSID/channel from the previous boot is used if it is valid.
+ */
+void Init_Wifi() {
+  IPAddress local_IP(WIFI_LOCAL_IP);
+  IPAddress gateway(WIFI_GATEWAY);
+  IPAddress subnet(WIFI_SUBNET);
+  IPAddress primaryDNS(WIFI_DNS);
+
+  WiFi.persistent(false); /* Do not write the credentials to flash on every begin() */
+  WiFi.mode(WIFI_STA); /* LOLIN ESP8266 as client */
+  WiFi.setAutoReconnect(false);
+
+  // Static IP address
+  if (!WiFi.config(local_IP, gateway, subnet, primaryDNS)) {
+    CONSOLE_ERROR("Static IP configuration failed!");
+  }
+
+  /* Event handlers run in the SDK context, only the flags are set there */
+  WU_GotIpHandler = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP&) {
+    WU_EventGotIp = true;
+  });
+  WU_DisconnectedHandler = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected& event) {
+    /* The leave caused by WiFi.disconnect()/begin() is not a failure of the next attempt */
+    if (WIFI_DISCONNECT_REASON_ASSOC_LEAVE != event.reason) {
+      WU_EventDisconnected = true;
+    }
+  });
+
+  /* SNTP client of the SDK, synchronizes in the background once the station is up */
+  configTime(0, 0, WIFI_NTP_SERVER);
+
+  WU_RetryCount = 0;
+  WU_UseCache = ReadRtcRecord(RTC_OFFSET_WIFI, &WU_Cache, sizeof(WU_Cache));
+  WU_Begin();
+}
+
+/**
+ * @brief Runs the WiFi retry schedule.
+ * States: connecting (wait for the event or timeout) / connected (wait for 
+ * the disconnect event) / waiting for retry (fast retries from WU_RetryDelays, 
+ * then one retry every WIFI_RETRY_SLOW).
+ * The got-IP event is accepted in any state while the station is still up 
+ * (an event raised just before the timeout is not lost). A timed out attempt 
+ * is stopped by WiFi.disconnect(), otherwise the SDK keeps trying in the 
+ * background while a retry is planned.
+ */
+void Run_Wifi() {
+  bool gotIp = WU_EventGotIp;
+  bool disconnected = WU_EventDisconnected;
+  WU_EventGotIp = false;
+  WU_EventDisconnected = false;
+
+  if (gotIp && (WU_STATE_CONNECTED != WU_CurrentState) && (WL_CONNECTED == WiFi.status())) {
+    WU_RetryCount = 0;
+    WU_SetState(WU_STATE_CONNECTED);
+    WU_SaveCache();
+    WU_PrintConnected();
+    return;
+  }
+
+  switch (WU_CurrentState) {
+    case WU_STATE_CONNECTING:
+      if (disconnected || ((millis() - WU_StateTime) >= (WU_UseCache ? WIFI_FAST_CONNECT_TIMEOUT : WIFI_CONNECT_TIMEOUT))) {
+        CONSOLE_WARN("WiFi connection failed.");
+        WiFi.disconnect();
+        WU_Failed();
+      }
+      break;
+
+    case WU_STATE_CONNECTED:
+      /* The status check also covers a lost link reported as a leave of the AP */
+      if (disconnected || (WL_CONNECTED != WiFi.status())) {
+        CONSOLE_WARN("WiFi connection lost.");
+        WU_RetryCount = 0;
+        /* First retry immediately */
+        WU_Begin();
+      }
+      break;
+
+    case WU_STATE_WAIT_RETRY:
+    default:
+      if ((millis() - WU_StateTime) >= WU_GetRetryDelay()) {
+        WU_Begin();
+      }
+      break;
+  }
+}
+
+/**
+ * @brief Checks if the WiFi station is connected and has an IP address.
+ * @return bool True if connected.
+ */
+bool IsWifiConnected() {
+  return (WU_STATE_CONNECTED == WU_CurrentState);
+}
+#endif /* WIFI_ACTIVE */
@@ -0,0 +1,66 @@
+/**
+ * @file WifiUtils.h
+ * @brief Header file for the non-blocking WiFi connection handling.
+ * The connection is driven by the WiFi station events (got IP / disconnected) 
+ * and a bounded retry schedule, so setup() never waits for the access point 
+ * and the network comes up in the background. The BSSID and channel of the 
+ * last good connection are cached in the RTC memory to skip the AP scan.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+#ifndef WIFI_UTILS_H
+#define WIFI_UTILS_H
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include "Global.h"
+
+// --------------------------------------------------------------------------
+// CONSTANTS
+// --------------------------------------------------------------------------
+
+/* WiFi credentials */
+#define WIFI_SSID "YOUR_WIFI_SSID" 
+#define WIFI_PASSWORD "YOUR_WIFI_PASSWORD"
+
+/* Static IP configuration */
+#define WIFI_LOCAL_IP 192, 168, 241, 120
+#define WIFI_GATEWAY 192, 168, 241, 1
+#define WIFI_SUBNET 255, 255, 255, 0
+#define WIFI_DNS 192, 168, 241, 1
+
+/* Network time (SNTP, UTC), used for the time stamps of the logged samples */
+#define WIFI_NTP_SERVER "pool.ntp.org"
+
+/* Retry configuration */
+#define WIFI_CONNECT_TIMEOUT 10000 /* Max. duration of one connection attempt [ms] */
+#define WIFI_FAST_CONNECT_TIMEOUT 3000 /* Max. duration of the attempt with cached BSSID/channel [ms] */
+#define WIFI_RETRY_BUDGET 5 /* Number of fast retries (see WU_RetryDelays) */
+#define WIFI_RETRY_SLOW 300000 /* Retry period after the fast retries are used up [ms] */
+
+// --------------------------------------------------------------------------
+// PUBLIC FUNCTION PROTOTYPE
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Configures the WiFi station, registers the event handlers and starts 
+ * the first connection attempt. Returns immediately.
+ */
+void Init_Wifi(void);
+
+/**
+ * @brief Runs the WiFi retry schedule. Must be called periodically (every scheduler pass).
+ */
+void Run_Wifi(void);
+
+/**
+ * @brief Checks if the WiFi station is connected and has an IP address.
+ * @return bool True if connected.
+ */
+bool IsWifiConnected(void);
+
+#endif // WIFI_UTILS_H
@@ -0,0 +1,311 @@
+/**
+ * @file DataUtilsReplay.cpp
+ * @brief Host-side (x86) replay, golden check and benchmark of DataUtils.
+ * Feeds a recorded sample trace through the same DataUtils.cpp as the
+ * sketch (Run_TmprHumiSmooth(), AddTmprToTrendBuffer(), GetTemperatureTrend()),
+ * writes or checks the per-sample outputs against a golden file and
+ * measures the filter engines (float, fixed-point, batched channels).
+ *
+ * Build (no Arduino core needed): "make replay" in this directory (see the
+ * Makefile), "make check" replays sample_trace.csv with both filter engines
+ * against sample_golden_fixed.csv / sample_golden_float.csv. By hand:
+ *   g++ -std=gnu++17 -O2 -Wall -I. tools/DataUtilsReplay/DataUtilsReplay.cpp DataUtils.cpp -o du_replay
+ *
+ * Usage:
+ *   ./du_replay trace.csv                      replay, print the outputs
+ *   ./du_replay trace.csv --write-golden g.csv save the outputs as the golden file
+ *   ./du_replay trace.csv --golden g.csv       compare with the golden file (exit 1 on mismatch)
+ *   ./du_replay trace.csv --bench 200          benchmark, 200 passes over the trace
+ *
+ * Trace format (CSV export of the MQTT archive): one sample per line
+ * "temperature,humidity" or "timestamp,temperature,humidity", lines
+ * which do not start with a number (header) are skipped. The samples
+ * are equidistant (--period [ms], default TREND_SAMPLE_TIME).
+ *
+ * Note: on the host SL is 64-bit (long), the fixed-point results are
+ * the same as on the ESP8266 as long as the values fit into 32 bits.
+ * @author Jan Olajec
+ * @date 14.10.2026
+ * @copyright Copyright (c) 2025 Jan OLAJEC, All rights reserved.
+ * @license This project is licensed under the MIT License
+ */
+
+// --------------------------------------------------------------------------
+// INCLUDES
+// --------------------------------------------------------------------------
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> /* __rdtsc() */
+#define RP_HAS_TSC 1
+#else
+#define RP_HAS_TSC 0
+#endif
+#include "Global.h"
+#include "DataUtils.h"
+#include "FilterUtils.h"
+
+// --------------------------------------------------------------------------
+// PRIVATE CONSTANTS
+// --------------------------------------------------------------------------
+
+#define RP_LINE_LEN 256 /* Maximal length of one CSV line */
+#define RP_DEFAULT_PASSES 100 /* Default number of the benchmark passes */
+
+// --------------------------------------------------------------------------
+// PRIVATE TYPES
+// --------------------------------------------------------------------------
+
+/**
+ * @brief One recorded sample.
+ */
+typedef struct {
+  float t; /* Raw temperature [C] */
+  float h; /* Raw humidity [%] */
+} RP_Sample;
+
+/**
+ * @brief Result of one benchmark run.
+ */
+typedef struct {
+  double nsPerSample;
+  double cyclesPerSample; /* Host TSC cycles, 0 without TSC */
+  double checksum;        /* Keeps the optimizer from removing the loop */
+} RP_BenchResult;
+
+// --------------------------------------------------------------------------
+// PRIVATE FUNCTIONS
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Reads the trace (the last two numeric columns of each line).
+ */
+PRIVATE bool RP_LoadTrace(const char* path, std::vector<RP_Sample>* samples) {
+  FILE* file = fopen(path, "r");
+  char line[RP_LINE_LEN];
+
+  if (nullptr == file) {
+    fprintf(stderr, "ERROR: Can not open %s\n", path);
+    return false;
+  }
+
+  while (nullptr != fgets(line, sizeof(line), file)) {
+    float col[3];
+    int count = sscanf(line, "%f,%f,%f", &col[0], &col[1], &col[2]);
+    if (count < 2) {
+      continue; /* Header or empty line */
+    }
+    RP_Sample sample = {col[count - 2], col[count - 1]};
+    samples->push_back(sample);
+  }
+
+  fclose(file);
+  return !samples->empty();
+}
+
+/**
+ * @brief Formats the outputs of one sample (the golden file line).
+ */
+PRIVATE void RP_FormatOutput(char* out, size_t len, SL t_filt, SL h_filt, SB trend, float rate) {
+  snprintf(out, len, "%.2f,%.2f,%d,%.3f", FromFx<DU_DECIMALS>(t_filt), FromFx<DU_DECIMALS>(h_filt), trend, rate);
+}
+
+/**
+ * @brief Replays the trace through DataUtils (same call order as Task_Filter()).
+ * @return int Number of the mismatches against the golden file.
+ */
+PRIVATE int RP_Replay(const std::vector<RP_Sample>& samples, unsigned long period, FILE* golden, FILE* output) {
+  char line[RP_LINE_LEN];
+  char expected[RP_LINE_LEN];
+  int mismatches = 0;
+
+  SetTrendSampleTime(period);
+  Init_TmprSmooth(QuantizeFx<DU_DECIMALS>(samples[0].t));
+  Init_HumiSmooth(QuantizeFx<DU_DECIMALS>(samples[0].h));
+  Init_TmprTrendBuffer(QuantizeFx<DU_DECIMALS>(samples[0].t));
+
+  for (size_t i = 1; i < samples.size(); i++) {
+    SL t_raw = QuantizeFx<DU_DECIMALS>(samples[i].t);
+    SL h_raw = QuantizeFx<DU_DECIMALS>(samples[i].h);
+    SL t_filt;
+    SL h_filt;
+
+    AddTmprToTrendBuffer(t_raw);
+    Run_TmprHumiSmooth(t_raw, h_raw, &t_filt, &h_filt);
+    RP_FormatOutput(line, sizeof(line), t_filt, h_filt, GetTemperatureTrend(), GetTmprTrendRate());
+
+    if (nullptr != output) {
+      fprintf(output, "%s\n", line);
+    }
+    if (nullptr != golden) {
+      if ((nullptr == fgets(expected, sizeof(expected), golden))) {
+        expected[0] = '\0';
+      }
+      expected[strcspn(expected, "\r\n")] = '\0';
+      if (0 != strcmp(line, expected)) {
+        if (mismatches < 10) {
+          fprintf(stderr, "MISMATCH sample %zu: got %s, expected %s\n", i, line, expected);
+        }
+        mismatches++;
+      }
+    }
+  }
+  return mismatches;
+}
+
+/**
+ * @brief Measures one variant (lambda called once per sample) over all passes.
+ */
+template <typename STEP>
+PRIVATE RP_BenchResult RP_Bench(const std::vector<RP_Sample>& samples, int passes, STEP step) {
+  RP_BenchResult result = {0.0, 0.0, 0.0};
+  auto start = std::chrono::steady_clock::now();
+#if (RP_HAS_TSC == 1)
+  unsigned long long tscStart = __rdtsc();
+#endif
+
+  for (int p = 0; p < passes; p++) {
+    for (size_t i = 0; i < samples.size(); i++) {
+      result.checksum += step(samples[i]);
+    }
+  }
+
+#if (RP_HAS_TSC == 1)
+  unsigned long long tscEnd = __rdtsc();
+#endif
+  auto end = std::chrono::steady_clock::now();
+  double count = (double)passes * samples.size();
+  result.nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / count;
+#if (RP_HAS_TSC == 1)
+  result.cyclesPerSample = (double)(tscEnd - tscStart) / count;
+#endif
+  return result;
+}
+
+/**
+ * @brief Prints one benchmark line.
+ */
+PRIVATE void RP_PrintBench(const char* name, const RP_BenchResult& result) {
+  printf("%-28s %8.2f ns/sample %8.1f cycles/sample (checksum %.2f)\n",
+         name, result.nsPerSample, result.cyclesPerSample, result.checksum);
+}
+
+/**
+ * @brief Benchmarks the filter engines and the whole DataUtils sample path.
+ * The engines are instantiated from FilterUtils.h with the sketch ALPHA,
+ * independent of the DU_FIXED_POINT selection.
+ */
+PRIVATE void RP_RunBenchmarks(const std::vector<RP_Sample>& samples, int passes) {
+  ExpSmoothFilter<float, ALPHA_NUM, ALPHA_DEN, DU_CHANNELS> filterFloat = {{(float)DEFAULT_TEMP, (float)DEFAULT_HUMI}};
+  ExpSmoothFilter<SL, ALPHA_NUM, ALPHA_DEN, DU_CHANNELS> filterFx;
+  ExpSmoothFilter<SL, ALPHA_NUM, ALPHA_DEN, DU_CHANNELS> filterBatch;
+
+  filterFx.Init(DU_CH_TMPR, QuantizeFx<DU_DECIMALS>(DEFAULT_TEMP));
+  filterFx.Init(DU_CH_HUMI, QuantizeFx<DU_DECIMALS>(DEFAULT_HUMI));
+  filterBatch = filterFx;
+
+  printf("Benchmark: %zu samples x %d passes\n", samples.size(), passes);
+
+  RP_PrintBench("float (per channel)", RP_Bench(samples, passes, [&](const RP_Sample& s) {
+    return (double)(filterFloat.Run(DU_CH_TMPR, s.t) + filterFloat.Run(DU_CH_HUMI, s.h));
+  }));
+
+  RP_PrintBench("fixed-point (per channel)", RP_Bench(samples, passes, [&](const RP_Sample& s) {
+    SL t = filterFx.Run(DU_CH_TMPR, QuantizeFx<DU_DECIMALS>(s.t));
+    SL h = filterFx.Run(DU_CH_HUMI, QuantizeFx<DU_DECIMALS>(s.h));
+    return (double)(t + h);
+  }));
+
+  RP_PrintBench("fixed-point (batched)", RP_Bench(samples, passes, [&](const RP_Sample& s) {
+    SL raw[DU_CHANNELS] = {QuantizeFx<DU_DECIMALS>(s.t), QuantizeFx<DU_DECIMALS>(s.h)};
+    SL filtered[DU_CHANNELS];
+    filterBatch.RunAll(raw, filtered);
+    return (double)(filtered[DU_CH_TMPR] + filtered[DU_CH_HUMI]);
+  }));
+
+  RP_PrintBench("DataUtils sample path", RP_Bench(samples, passes, [&](const RP_Sample& s) {
+    SL t_raw = QuantizeFx<DU_DECIMALS>(s.t);
+    SL h_raw = QuantizeFx<DU_DECIMALS>(s.h);
+    SL t_filt;
+    SL h_filt;
+    AddTmprToTrendBuffer(t_raw);
+    Run_TmprHumiSmooth(t_raw, h_raw, &t_filt, &h_filt);
+    return (double)(t_filt + h_filt + GetTemperatureTrend());
+  }));
+
+  RP_PrintBench("trend rate (regression)", RP_Bench(samples, passes, [&](const RP_Sample&) {
+    return (double)GetTmprTrendRate();
+  }));
+}
+
+// --------------------------------------------------------------------------
+// MAIN
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  const char* goldenPath = nullptr;
+  const char* writePath = nullptr;
+  unsigned long period = TREND_SAMPLE_TIME;
+  int passes = 0;
+  std::vector<RP_Sample> samples;
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s trace.csv [--golden f] [--write-golden f] [--period ms] [--bench passes]\n", argv[0]);
+    return 2;
+  }
+  for (int i = 2; i < argc; i++) {
+    if ((0 == strcmp(argv[i], "--golden")) && ((i + 1) < argc)) {
+      goldenPath = argv[++i];
+    } else if ((0 == strcmp(argv[i], "--write-golden")) && ((i + 1) < argc)) {
+      writePath = argv[++i];
+    } else if ((0 == strcmp(argv[i], "--period")) && ((i + 1) < argc)) {
+      period = strtoul(argv[++i], nullptr, 10);
+    } else if (0 == strcmp(argv[i], "--bench")) {
+      passes = ((i + 1) < argc) ? atoi(argv[++i]) : RP_DEFAULT_PASSES;
+    } else {
+      fprintf(stderr, "ERROR: Unknown argument %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  if (!RP_LoadTrace(argv[1], &samples)) {
+    fprintf(stderr, "ERROR: No samples in %s\n", argv[1]);
+    return 2;
+  }
+
+  if (passes > 0) {
+    RP_RunBenchmarks(samples, passes);
+    return 0;
+  }
+
+  FILE* golden = nullptr;
+  FILE* output = stdout;
+  if (nullptr != goldenPath) {
+    golden = fopen(goldenPath, "r");
+    if (nullptr == golden) {
+      fprintf(stderr, "ERROR: Can not open %s\n", goldenPath);
+      return 2;
+    }
+    output = nullptr;
+  } else if (nullptr != writePath) {
+    output = fopen(writePath, "w");
+    if (nullptr == output) {
+      fprintf(stderr, "ERROR: Can not create %s\n", writePath);
+      return 2;
+    }
+  }
+
+  int mismatches = RP_Replay(samples, period, golden, output);
+
+  if (nullptr != golden) {
+    fclose(golden);
+    printf("%s: %zu samples, %d mismatches\n", (0 == mismatches) ? "PASS" : "FAIL", samples.size() - 1, mismatches);
+  } else if (stdout != output) {
+    fclose(output);
+    printf("Golden file %s written (%zu samples)\n", writePath, samples.size() - 1);
+  }
+  return (0 == mismatches) ? 0 : 1;
+}